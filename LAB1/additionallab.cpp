@@ -1,7 +1,8 @@
 #include <iostream>
-#include <vector>
 #include <omp.h>
 #include <iomanip>
+#include "../common/matrix.h"
+#include "../common/transpose.h"
 
 using namespace std;
 
@@ -9,16 +10,20 @@ using namespace std;
 // Start with 500 or 1000. 2000+ might take a while on sequential.
 const int N = 1000; 
 
-void initialize(vector<vector<double>>& A) {
+// One contiguous, 64-byte aligned block per matrix (common/matrix.h)
+typedef Matrix<double> Mat;
+
+void initialize(Mat& A) {
     for (int i = 0; i < N; i++)
         for (int j = 0; j < N; j++)
-            A[i][j] = (double)rand() / RAND_MAX;
+            A(i, j) = (double)rand() / RAND_MAX;
 }
 
 int main() {
-    vector<vector<double>> A(N, vector<double>(N));
-    vector<vector<double>> B(N, vector<double>(N));
-    vector<vector<double>> C(N, vector<double>(N, 0.0));
+    Mat A(N, N);
+    Mat B(N, N);
+    Mat C(N, N);
+    C.fill(0.0);
 
     initialize(A);
     initialize(B);
@@ -32,15 +37,15 @@ int main() {
     for (int i = 0; i < N; i++) {
         for (int j = 0; j < N; j++) {
             for (int k = 0; k < N; k++) {
-                C[i][j] += A[i][k] * B[k][j];
+                C(i, j) += A(i, k) * B(k, j);
             }
         }
     }
     double t_seq = omp_get_wtime() - start;
     cout << "Sequential Time:      " << fixed << setprecision(4) << t_seq << "s" << endl;
 
-    // Reset C
-    fill(C.begin(), C.end(), vector<double>(N, 0.0));
+    // Reset C (in place, no reallocation)
+    C.fill(0.0);
 
     // 2. BASIC OPENMP
     start = omp_get_wtime();
@@ -49,28 +54,23 @@ int main() {
         for (int j = 0; j < N; j++) {
             double sum = 0;
             for (int k = 0; k < N; k++) {
-                sum += A[i][k] * B[k][j];
+                sum += A(i, k) * B(k, j);
             }
-            C[i][j] = sum;
+            C(i, j) = sum;
         }
     }
     double t_par = omp_get_wtime() - start;
     cout << "Basic OpenMP Time:    " << t_par << "s (Speedup: " << t_seq/t_par << "x)" << endl;
 
-    // Reset C
-    fill(C.begin(), C.end(), vector<double>(N, 0.0));
+    // Reset C (in place, no reallocation)
+    C.fill(0.0);
 
     // 3. TRANSPOSED OPENMP (Optimized Memory Access)
     start = omp_get_wtime();
-    vector<vector<double>> BT(N, vector<double>(N));
+    Mat BT(N, N);
     
-    // Transpose B
-    #pragma omp parallel for collapse(2)
-    for (int i = 0; i < N; i++) {
-        for (int j = 0; j < N; j++) {
-            BT[j][i] = B[i][j];
-        }
-    }
+    // Transpose B (cache-oblivious, SIMD tiles: common/transpose.h)
+    transpose(B.view(), BT.view());
 
     // Multiply using Transposed B
     #pragma omp parallel for collapse(2)
@@ -78,9 +78,9 @@ int main() {
         for (int j = 0; j < N; j++) {
             double sum = 0;
             for (int k = 0; k < N; k++) {
-                sum += A[i][k] * BT[j][k]; // Sequential access for both!
+                sum += A(i, k) * BT(j, k); // Sequential access for both!
             }
-            C[i][j] = sum;
+            C(i, j) = sum;
         }
     }
     double t_opt = omp_get_wtime() - start;
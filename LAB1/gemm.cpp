@@ -0,0 +1,241 @@
+#include "gemm.h"
+#include "gemm_internal.h"
+#include "gemm_kernels.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  BLOCKED GEMM
+//
+//  The Goto / BLIS loop nest around an MR × NR register micro-kernel:
+//
+//    for jc  (NC columns of C)          B panel  KC × NC   shared, L3
+//      for pc  (KC of the k dimension)  packed by the whole team
+//        for ic  (MC rows of C)         A block  MC × KC   per thread, L2
+//          for jr  (NR)                 B micro-panel      L1
+//            for ir  (MR)               micro-kernel on MR × NR of C
+//
+//  Packing copies each block of op(A) and op(B) once per use into the
+//  contiguous, zero-padded order the micro-kernel reads, so the transposes
+//  cost nothing past the packing, edge tiles need no special case inside
+//  the k loop, and every load in that loop is unit-stride.
+//
+//  OpenMP: one parallel region for the whole call.  The team packs the B
+//  panel together (one barrier), then shares out macro-tiles — an MC row
+//  block of C times a run of NR micro-panels — dynamically; the run is cut
+//  shorter when there are too few row blocks to keep every thread busy.
+//
+//  gemm() allocates the packing buffers per call; gemm_ws() runs on the
+//  caller's scratch instead, for callers that must not allocate (the
+//  Strassen leaves, strassen.cpp).
+// ─────────────────────────────────────────────────────────────────────────────
+
+static int isa_rank(const char* name)
+{
+    if (!std::strcmp(name, "avx512")) return 2;
+    if (!std::strcmp(name, "avx2"))   return 1;
+    if (!std::strcmp(name, "sse2"))   return 0;
+    return -1;
+}
+
+static const GemmKernel& detect_kernel()
+{
+    __builtin_cpu_init();
+    int best = 0;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        best = 1;
+    if (best == 1 && __builtin_cpu_supports("avx512f"))
+        best = 2;
+
+    int level = best;
+    const char* env = std::getenv("GEMM_ISA");
+    if (env && *env) {
+        int forced = isa_rank(env);
+        if (forced < 0)
+            std::fprintf(stderr, "gemm: ignoring unknown GEMM_ISA=%s\n", env);
+        else if (forced > best)
+            std::fprintf(stderr, "gemm: GEMM_ISA=%s not supported by this CPU, "
+                                 "using the best available level\n", env);
+        else
+            level = forced;
+    }
+
+    switch (level) {
+    case 2:  return gemm_kernel_avx512();
+    case 1:  return gemm_kernel_avx2();
+    default: return gemm_kernel_sse2();
+    }
+}
+
+static const GemmKernel& select_kernel()
+{
+    static const GemmKernel& k = detect_kernel();
+    return k;
+}
+
+const char* gemm_isa()
+{
+    return select_kernel().isa;
+}
+
+double* alloc_panel(size_t n)
+{
+    void* p = nullptr;
+    if (posix_memalign(&p, 64, std::max<size_t>(n, 1) * sizeof(double)) != 0)
+        return nullptr;
+    return (double*)p;
+}
+
+// op(X)(r, c) = X[r * rs + c * cs]: (ld, 1) as stored, (1, ld) transposed.
+
+// Rows [0, mc) × k [0, kc) of op(A) into MR-row micro-panels, k-major:
+// out[(i / MR) * MR * kc + k * MR + i % MR], rows past mc zero.
+static void pack_a(int mc, int kc, const double* a, long rs, long cs, int MR, double* out)
+{
+    for (int i0 = 0; i0 < mc; i0 += MR) {
+        const int m = std::min(MR, mc - i0);
+        for (int k = 0; k < kc; ++k) {
+            for (int i = 0; i < m; ++i)
+                out[k * MR + i] = a[(i0 + i) * rs + k * cs];
+            for (int i = m; i < MR; ++i)
+                out[k * MR + i] = 0.0;
+        }
+        out += (size_t)MR * kc;
+    }
+}
+
+// One NR-column micro-panel of op(B), k-major: out[k * NR + j], j >= n zero.
+static void pack_b(int kc, int n, const double* b, long rs, long cs, int NR, double* out)
+{
+    for (int k = 0; k < kc; ++k) {
+        for (int j = 0; j < n; ++j)
+            out[k * NR + j] = b[k * rs + j * cs];
+        for (int j = n; j < NR; ++j)
+            out[k * NR + j] = 0.0;
+    }
+}
+
+// row = beta · row (beta = 0 writes zeros, so NaN in C does not survive).
+static void scale_row(int n, double beta, double* row)
+{
+    if (beta == 0.0)
+        std::fill(row, row + n, 0.0);
+    else
+        for (int j = 0; j < n; ++j)
+            row[j] *= beta;
+}
+
+// Clipped block sizes of one call, and its scratch layout: the shared B
+// panel, then one A block per thread, each rounded to a cache line.
+struct Blocks {
+    int    MC, KC, NC;
+    size_t bpack, apack;   // doubles
+};
+
+static Blocks blocks_for(const GemmKernel& g, int M, int N, int K)
+{
+    Blocks b;
+    b.KC    = std::min(g.KC, K);
+    b.NC    = std::min(g.NC, (N + g.NR - 1) / g.NR * g.NR);
+    b.MC    = std::min(g.MC, (M + g.MR - 1) / g.MR * g.MR);
+    b.bpack = ((size_t)b.KC * b.NC + 7) / 8 * 8;
+    b.apack = ((size_t)b.MC * b.KC + 7) / 8 * 8;
+    return b;
+}
+
+size_t gemm_ws_size(int M, int N, int K, int threads)
+{
+    if (M <= 0 || N <= 0 || K <= 0)
+        return 0;
+    const Blocks b = blocks_for(select_kernel(), M, N, K);
+    return b.bpack + (size_t)threads * b.apack;
+}
+
+void gemm_ws(Transpose ta, Transpose tb, int M, int N, int K,
+             double alpha, const double* A, int lda,
+             const double* B, int ldb,
+             double beta, double* C, int ldc,
+             double* ws, int threads)
+{
+    if (M <= 0 || N <= 0)
+        return;
+    if (beta != 1.0) {
+#pragma omp parallel for schedule(static) num_threads(threads) if (threads > 1)
+        for (int i = 0; i < M; ++i)
+            scale_row(N, beta, C + (long)i * ldc);
+    }
+    if (K <= 0 || alpha == 0.0)
+        return;
+
+    const GemmKernel& g = select_kernel();
+    const Blocks      bl = blocks_for(g, M, N, K);
+    const int  MR = g.MR, NR = g.NR;
+    const int  MC = bl.MC, KC = bl.KC, NC = bl.NC;
+    const long ars = (ta == Transpose::No) ? lda : 1, acs = (ta == Transpose::No) ? 1 : lda;
+    const long brs = (tb == Transpose::No) ? ldb : 1, bcs = (tb == Transpose::No) ? 1 : ldb;
+    const int  mblocks = (M + MC - 1) / MC;
+    double*    bpack = ws;
+
+#pragma omp parallel num_threads(threads) if (threads > 1)
+    {
+        double* apack = ws + bl.bpack + (size_t)omp_get_thread_num() * bl.apack;
+
+        for (int jc = 0; jc < N; jc += NC) {
+            const int nc      = std::min(NC, N - jc);
+            const int npanels = (nc + NR - 1) / NR;
+            // Enough macro-tiles for ~4 per thread, never below one panel.
+            const int split   = std::min(npanels, std::max(1, (4 * threads + mblocks - 1) / mblocks));
+            const int per     = (npanels + split - 1) / split;
+            const int tiles   = mblocks * split;
+
+            for (int pc = 0; pc < K; pc += KC) {
+                const int kc = std::min(KC, K - pc);
+
+#pragma omp for schedule(static)
+                for (int p = 0; p < npanels; ++p)
+                    pack_b(kc, std::min(NR, nc - p * NR), B + pc * brs + (long)(jc + p * NR) * bcs,
+                           brs, bcs, NR, bpack + (size_t)p * NR * kc);
+
+#pragma omp for schedule(dynamic, 1)
+                for (int t = 0; t < tiles; ++t) {
+                    const int ic = (t / split) * MC;
+                    const int mc = std::min(MC, M - ic);
+                    const int p0 = (t % split) * per, p1 = std::min(npanels, p0 + per);
+                    if (p0 >= p1)
+                        continue;
+                    pack_a(mc, kc, A + (long)ic * ars + pc * acs, ars, acs, MR, apack);
+
+                    for (int p = p0; p < p1; ++p) {
+                        const int jr = p * NR;
+                        const int n  = std::min(NR, nc - jr);
+                        for (int ir = 0; ir < mc; ir += MR)
+                            g.ukernel(kc, apack + (size_t)ir * kc, bpack + (size_t)p * NR * kc, alpha,
+                                      C + (long)(ic + ir) * ldc + jc + jr, ldc, std::min(MR, mc - ir), n);
+                    }
+                }
+                // The implicit barrier keeps bpack alive until every tile is done.
+            }
+        }
+    }
+}
+
+void gemm(Transpose ta, Transpose tb, int M, int N, int K,
+          double alpha, const double* A, int lda,
+          const double* B, int ldb,
+          double beta, double* C, int ldc)
+{
+    const int threads = omp_get_max_threads();
+    double* ws = nullptr;
+    if (K > 0 && alpha != 0.0 && M > 0 && N > 0) {
+        ws = alloc_panel(gemm_ws_size(M, N, K, threads));
+        if (!ws) {
+            std::fprintf(stderr, "gemm: out of memory for the packing buffers\n");
+            return;
+        }
+    }
+    gemm_ws(ta, tb, M, N, K, alpha, A, lda, B, ldb, beta, C, ldc, ws, threads);
+    std::free(ws);
+}
@@ -0,0 +1,72 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  gemm.h  –  blocked, packed double-precision matrix multiply (libgemm.a)
+//
+//  The N×N multiplies of additionallab.cpp and q2_matrix.c as a library
+//  routine: any M, N, K, either operand transposed, row-major storage with
+//  leading dimensions, so sub-matrices can be passed in place.
+// ─────────────────────────────────────────────────────────────────────────────
+
+enum class Transpose {
+    No,    // op(X) = X
+    Yes    // op(X) = Xᵀ
+};
+
+/**
+ * C = alpha · op(A) · op(B) + beta · C, all matrices row-major.
+ *
+ * @param ta, tb  whether A / B are used transposed
+ * @param M, N, K op(A) is M × K, op(B) is K × N, C is M × N
+ * @param A       element (r, c) of the stored matrix at A[r * lda + c];
+ *                stored as M × K (ta = No) or K × M (ta = Yes)
+ * @param lda     row stride of A in elements (>= its stored column count)
+ * @param B, ldb  likewise, K × N or N × K
+ * @param C, ldc  M × N result; with beta = 0 it is not read, so it may
+ *                hold NaN or garbage
+ *
+ * Runs on the current OpenMP team size (omp_set_num_threads).  The
+ * micro-kernel is picked at first use from cpuid (AVX-512, AVX2 + FMA, or
+ * SSE2); GEMM_ISA=sse2|avx2 forces a lower level for A/B runs.
+ */
+void gemm(Transpose ta, Transpose tb, int M, int N, int K,
+          double alpha, const double* A, int lda,
+          const double* B, int ldb,
+          double beta, double* C, int ldc);
+
+/**
+ * C = A · B for square N × N row-major matrices by Strassen-Winograd
+ * recursion (strassen.cpp): 7 half-size products and 15 additions per
+ * level instead of 8 products, down to gemm() at `cutoff`.  Odd sizes
+ * peel off their last row and column into gemm() calls.
+ *
+ * The recursion never allocates: all temporaries and the gemm() packing
+ * buffers come from one arena of gemm_strassen_workspace(N, cutoff)
+ * doubles.  Pass it as `workspace` (64-byte aligned, e.g. from
+ * posix_memalign) to reuse it across calls, or nullptr to have it
+ * allocated and freed per call.  Both depend on the current OpenMP team
+ * size: with more than one thread the products of the top levels run as
+ * nested tasks, about 4 per thread, and each task level adds to the arena.
+ *
+ * The result differs from gemm()'s by rounding only, but the error bound
+ * grows with the number of levels; gemm_bench --strassen reports the
+ * measured error per cutoff.
+ *
+ * @param cutoff  sizes <= cutoff go to gemm(); <= 0 selects STRASSEN_CUTOFF
+ */
+const int STRASSEN_CUTOFF = 512;
+
+size_t gemm_strassen_workspace(int N, int cutoff);
+
+void gemm_strassen(int N, const double* A, int lda,
+                   const double* B, int ldb,
+                   double* C, int ldc,
+                   int cutoff, double* workspace);
+
+/** ISA level of the micro-kernel gemm() uses: "avx512", "avx2" or "sse2". */
+const char* gemm_isa();
+
+#endif // GEMM_H
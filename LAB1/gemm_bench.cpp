@@ -0,0 +1,295 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <omp.h>
+#include "gemm.h"
+#include "../common/matrix.h"
+#include "../common/transpose.h"
+
+using namespace std;
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Usage:
+//    ./gemm_bench [N | M N K] [--threads T] [--no-seq] [--check]
+//                 [--strassen CUTOFFS]
+//
+//  Times the three multiplies of additionallab.cpp (generalised to
+//  op(A) M × K, op(B) K × N) against gemm(), in the same output format,
+//  with GFLOP/s (2·M·N·K flops) next to each time.
+//
+//  N          square size (default 1000, as additionallab.cpp)
+//  --threads  OpenMP team size (default: system max)
+//  --no-seq   skip the sequential i-j-k run (minutes at N >= 2000); the
+//             speedups are then against Basic OpenMP
+//  --check    run gemm() over odd shapes, all four transpose combinations,
+//             sub-matrix leading dimensions and alpha / beta, against a
+//             naive reference, plus gemm_strassen() at small cutoffs, and
+//             exit
+//  --strassen comma-separated cutoffs (0 = STRASSEN_CUTOFF): time
+//             gemm_strassen() at each against gemm() on the square N, with
+//             effective GFLOP/s (2·N³ / t) and its error against gemm()
+// ─────────────────────────────────────────────────────────────────────────────
+
+typedef Matrix<double> Mat;
+
+static void initialize(Mat& A) {
+    for (int i = 0; i < A.rows(); i++)
+        for (int j = 0; j < A.cols(); j++)
+            A(i, j) = (double)rand() / RAND_MAX;
+}
+
+static double gflops(int M, int N, int K, double t) {
+    return 2.0 * M * N * K / t * 1e-9;
+}
+
+static void report(const char* label, double t, double t_ref, int M, int N, int K) {
+    cout << label << fixed << setprecision(4) << t << "s";
+    if (t_ref > 0)
+        cout << " (Speedup: " << t_ref / t << "x)";
+    cout << "  [" << setprecision(2) << gflops(M, N, K, t) << " GFLOP/s]" << endl;
+}
+
+// Naive op(A) op(B) for --check, in long double so the reference is exact
+// enough to compare against at any K used here.
+static void reference(Transpose ta, Transpose tb, int M, int N, int K, double alpha,
+                      const vector<double>& A, int lda, const vector<double>& B, int ldb,
+                      double beta, vector<double>& C, int ldc) {
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < N; j++) {
+            long double s = 0;
+            for (int k = 0; k < K; k++) {
+                double a = (ta == Transpose::No) ? A[(size_t)i * lda + k] : A[(size_t)k * lda + i];
+                double b = (tb == Transpose::No) ? B[(size_t)k * ldb + j] : B[(size_t)j * ldb + k];
+                s += (long double)a * b;
+            }
+            double& c = C[(size_t)i * ldc + j];
+            c = (double)(alpha * s + (beta == 0.0 ? 0.0L : (long double)beta * c));
+        }
+}
+
+static int check() {
+    const int sizes[] = { 1, 2, 7, 23, 64, 97, 200, 301 };
+    const int nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    const double scalars[][2] = { { 1.0, 0.0 }, { -0.5, 1.0 }, { 2.0, -1.5 } };
+    double max_err = 0;
+    int cases = 0;
+    srand(7);
+
+    for (int s = 0; s < nsizes * nsizes; s += 3) {
+        const int M = sizes[s % nsizes], N = sizes[(s / nsizes) % nsizes], K = sizes[(s * 5 + 3) % nsizes];
+        for (int t = 0; t < 4; t++) {
+            const Transpose ta = (t & 1) ? Transpose::Yes : Transpose::No;
+            const Transpose tb = (t & 2) ? Transpose::Yes : Transpose::No;
+            // Stored shapes, with 3 spare columns so ld > width.
+            const int ar = (ta == Transpose::No) ? M : K, ac = (ta == Transpose::No) ? K : M;
+            const int br = (tb == Transpose::No) ? K : N, bc = (tb == Transpose::No) ? N : K;
+            const int lda = ac + 3, ldb = bc + 3, ldc = N + 3;
+            vector<double> A((size_t)ar * lda), B((size_t)br * ldb), C0((size_t)M * ldc);
+            for (auto& x : A)  x = (double)rand() / RAND_MAX - 0.5;
+            for (auto& x : B)  x = (double)rand() / RAND_MAX - 0.5;
+            for (auto& x : C0) x = (double)rand() / RAND_MAX - 0.5;
+
+            for (const auto& ab : scalars) {
+                vector<double> C = C0, R = C0;
+                if (ab[1] == 0.0)
+                    for (int i = 0; i < M; i++)
+                        C[(size_t)i * ldc] = NAN;   // beta = 0 must not read C
+                gemm(ta, tb, M, N, K, ab[0], A.data(), lda, B.data(), ldb, ab[1], C.data(), ldc);
+                reference(ta, tb, M, N, K, ab[0], A, lda, B, ldb, ab[1], R, ldc);
+                for (int i = 0; i < M; i++)
+                    for (int j = 0; j < ldc; j++) {
+                        double e = fabs(C[(size_t)i * ldc + j] - R[(size_t)i * ldc + j]);
+                        if (j >= N)   // padding columns must be untouched
+                            e = (C[(size_t)i * ldc + j] == C0[(size_t)i * ldc + j]) ? 0.0 : 1.0;
+                        if (!(e <= max_err))
+                            max_err = std::isnan(e) ? INFINITY : e;
+                    }
+                cases++;
+            }
+        }
+    }
+    const bool ok = max_err <= 1e-12;
+    cout << "gemm() [" << gemm_isa() << "] check: " << cases << " cases, "
+         << (ok ? "PASSED" : "FAILED") << " (max |err| = " << scientific << max_err << ")" << endl;
+
+    // Strassen: even and odd sizes, several levels, padded leading dimensions.
+    const int ssizes[] = { 1, 16, 97, 200, 301 }, cutoffs[] = { 8, 24, 64 };
+    double s_err = 0;
+    int s_cases = 0;
+    for (int n : ssizes)
+        for (int cut : cutoffs) {
+            const int ld = n + 3;
+            vector<double> A((size_t)n * ld), B((size_t)n * ld), C((size_t)n * ld, NAN), R((size_t)n * ld);
+            for (auto& x : A) x = (double)rand() / RAND_MAX - 0.5;
+            for (auto& x : B) x = (double)rand() / RAND_MAX - 0.5;
+            gemm_strassen(n, A.data(), ld, B.data(), ld, C.data(), ld, cut, nullptr);
+            reference(Transpose::No, Transpose::No, n, n, n, 1.0, A, ld, B, ld, 0.0, R, ld);
+            for (int i = 0; i < n; i++)
+                for (int j = 0; j < n; j++) {
+                    double e = fabs(C[(size_t)i * ld + j] - R[(size_t)i * ld + j]);
+                    if (!(e <= s_err))
+                        s_err = std::isnan(e) ? INFINITY : e;
+                }
+            s_cases++;
+        }
+    const bool s_ok = s_err <= 1e-11;
+    cout << "gemm_strassen() check: " << s_cases << " cases, "
+         << (s_ok ? "PASSED" : "FAILED") << " (max |err| = " << scientific << s_err << ")" << endl;
+    return ok && s_ok ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> dims, cutoffs;
+    bool run_seq = true;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--threads") && a + 1 < argc)
+            omp_set_num_threads(atoi(argv[++a]));
+        else if (!strcmp(argv[a], "--no-seq"))
+            run_seq = false;
+        else if (!strcmp(argv[a], "--check"))
+            return check();
+        else if (!strcmp(argv[a], "--strassen") && a + 1 < argc)
+            for (char* tok = strtok(argv[++a], ","); tok; tok = strtok(nullptr, ","))
+                cutoffs.push_back(atoi(tok));
+        else
+            dims.push_back(atoi(argv[a]));
+    }
+    const int M = dims.empty() ? 1000 : dims[0];
+    const int N = dims.size() >= 3 ? dims[1] : M;
+    const int K = dims.size() >= 3 ? dims[2] : M;
+    if (M <= 0 || N <= 0 || K <= 0 || (dims.size() != 0 && dims.size() != 1 && dims.size() != 3) ||
+        (!cutoffs.empty() && (M != N || N != K))) {
+        cerr << "Usage: " << argv[0] << " [N | M N K] [--threads T] [--no-seq] [--check]"
+             << " [--strassen CUTOFFS (square N only)]" << endl;
+        return 1;
+    }
+
+    Mat A(M, K);
+    Mat B(K, N);
+    Mat C(M, N);
+    C.fill(0.0);
+    initialize(A);
+    initialize(B);
+
+    if (M == N && N == K)
+        cout << "Matrix Size: " << N << "x" << N << endl;
+    else
+        cout << "Matrix Size: " << M << "x" << K << " * " << K << "x" << N << endl;
+    cout << "Threads: " << omp_get_max_threads() << endl;
+    cout << "------------------------------------------" << endl;
+
+    // 1. SEQUENTIAL
+    double t_seq = 0, start;
+    if (run_seq) {
+        start = omp_get_wtime();
+        for (int i = 0; i < M; i++)
+            for (int j = 0; j < N; j++)
+                for (int k = 0; k < K; k++)
+                    C(i, j) += A(i, k) * B(k, j);
+        t_seq = omp_get_wtime() - start;
+        report("Sequential Time:      ", t_seq, 0, M, N, K);
+    }
+
+    // 2. BASIC OPENMP
+    start = omp_get_wtime();
+    #pragma omp parallel for collapse(2)
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            double sum = 0;
+            for (int k = 0; k < K; k++)
+                sum += A(i, k) * B(k, j);
+            C(i, j) = sum;
+        }
+    }
+    double t_par = omp_get_wtime() - start;
+    const double t_ref = run_seq ? t_seq : t_par;
+    report("Basic OpenMP Time:    ", t_par, run_seq ? t_seq : 0, M, N, K);
+
+    // 3. TRANSPOSED OPENMP
+    start = omp_get_wtime();
+    Mat BT(N, K);
+    transpose(B.view(), BT.view());
+    #pragma omp parallel for collapse(2)
+    for (int i = 0; i < M; i++) {
+        for (int j = 0; j < N; j++) {
+            double sum = 0;
+            for (int k = 0; k < K; k++)
+                sum += A(i, k) * BT(j, k);
+            C(i, j) = sum;
+        }
+    }
+    double t_opt = omp_get_wtime() - start;
+    report("Optimized (Transp):   ", t_opt, t_ref, M, N, K);
+
+    // 4. BLOCKED, PACKED GEMM, straight on the matrices above
+    Mat G(M, N);
+    gemm(Transpose::No, Transpose::No, M, N, K, 1.0, A.data(), A.stride(), B.data(), B.stride(),
+         0.0, G.data(), G.stride());   // warm-up
+    start = omp_get_wtime();
+    gemm(Transpose::No, Transpose::No, M, N, K, 1.0, A.data(), A.stride(), B.data(), B.stride(),
+         0.0, G.data(), G.stride());
+    double t_gemm = omp_get_wtime() - start;
+    const string label = string("gemm() [") + gemm_isa() + "]:";
+    report((label + string(max<int>(1, 22 - (int)label.size()), ' ')).c_str(), t_gemm, t_ref, M, N, K);
+
+    double err = 0;
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < N; j++)
+            err = max(err, fabs(G(i, j) - C(i, j)));
+    cout << "------------------------------------------" << endl;
+    cout << "Max |gemm - transposed|: " << scientific << setprecision(2) << err << endl;
+    if (cutoffs.empty())
+        return 0;
+
+    // 5. STRASSEN-WINOGRAD, one preallocated workspace per cutoff; the error
+    //    is against gemm(), relative to the largest |C| and in Frobenius norm.
+    cout << "------------------------------------------" << endl;
+    double cmax = 0, cnorm = 0;
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++) {
+            cmax = max(cmax, fabs(G(i, j)));
+            cnorm += G(i, j) * G(i, j);
+        }
+    cnorm = sqrt(cnorm);
+    Mat S(N, N);
+    for (int cut : cutoffs) {
+        const int co = cut > 0 ? cut : STRASSEN_CUTOFF;
+        int levels = 0;
+        for (int n = N; n > co; n /= 2)
+            levels++;
+        const size_t ws_size = gemm_strassen_workspace(N, co);
+        void* ws = nullptr;
+        if (posix_memalign(&ws, 64, max<size_t>(ws_size, 1) * sizeof(double)) != 0) {
+            cerr << "gemm_strassen: cannot allocate " << ws_size * sizeof(double) << " bytes" << endl;
+            return 1;
+        }
+        gemm_strassen(N, A.data(), A.stride(), B.data(), B.stride(), S.data(), S.stride(), co,
+                      (double*)ws);   // warm-up
+        start = omp_get_wtime();
+        gemm_strassen(N, A.data(), A.stride(), B.data(), B.stride(), S.data(), S.stride(), co,
+                      (double*)ws);
+        double t_str = omp_get_wtime() - start;
+        free(ws);
+
+        double emax = 0, efro = 0;
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++) {
+                const double e = S(i, j) - G(i, j);
+                emax = max(emax, fabs(e));
+                efro += e * e;
+            }
+        const string sl = "Strassen cut=" + to_string(co) + ":";
+        cout << (sl + string(max<int>(1, 22 - (int)sl.size()), ' ')) << fixed << setprecision(4) << t_str
+             << "s (vs gemm(): " << t_gemm / t_str << "x)  [" << setprecision(2) << gflops(N, N, N, t_str)
+             << " GFLOP/s eff]  levels " << levels << ", max |err| " << scientific << emax
+             << " (rel " << emax / cmax << "), Frobenius rel " << sqrt(efro) / cnorm
+             << ", workspace " << fixed << setprecision(1) << ws_size * sizeof(double) / 1048576.0
+             << " MiB" << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef GEMM_INTERNAL_H
+#define GEMM_INTERNAL_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Helpers shared by the libgemm translation units compiled for the
+//  baseline ISA (gemm.cpp, strassen.cpp).
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "gemm.h"
+#include <cstddef>
+
+// 64-byte aligned, uninitialised doubles (free with std::free); nullptr if
+// out of memory.
+double* alloc_panel(size_t n);
+
+// Scratch doubles gemm_ws() needs for one call of this shape on a team of
+// `threads`; constant in M, N and K once they exceed the cache blocks.
+size_t gemm_ws_size(int M, int N, int K, int threads);
+
+/**
+ * gemm() on caller-provided scratch: `ws` holds gemm_ws_size(M, N, K,
+ * threads) doubles, 64-byte aligned.  Runs on a team of `threads`; with 1
+ * its parallel regions are inactive (if clause), so it can run inside an
+ * OpenMP task.
+ */
+void gemm_ws(Transpose ta, Transpose tb, int M, int N, int K,
+             double alpha, const double* A, int lda,
+             const double* B, int ldb,
+             double beta, double* C, int ldc,
+             double* ws, int threads);
+
+#endif // GEMM_INTERNAL_H
@@ -0,0 +1,29 @@
+#ifndef GEMM_KERNELS_H
+#define GEMM_KERNELS_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Micro-kernels of gemm(), one table per ISA level (gemm_kernels_<isa>.cpp,
+//  each compiled with that level's -m flags; see Makefile).
+// ─────────────────────────────────────────────────────────────────────────────
+
+/**
+ * One MR × NR tile of C from packed micro-panels:
+ *   c[i * ldc + j] += alpha · Σ_k a[k * MR + i] · b[k * NR + j]
+ * for i < m <= MR, j < n <= NR.  `a` and `b` are zero-padded to MR / NR
+ * and 64-byte aligned; c is any row-major tile.
+ */
+typedef void (*gemm_ukernel_fn)(int kc, const double* a, const double* b,
+                                double alpha, double* c, int ldc, int m, int n);
+
+struct GemmKernel {
+    const char*     isa;
+    int             MR, NR;        // micro-tile, in registers
+    int             MC, KC, NC;    // A block (L2), B micro-panel depth (L1), B panel (L3)
+    gemm_ukernel_fn ukernel;
+};
+
+const GemmKernel& gemm_kernel_sse2();
+const GemmKernel& gemm_kernel_avx2();
+const GemmKernel& gemm_kernel_avx512();
+
+#endif // GEMM_KERNELS_H
@@ -0,0 +1,8 @@
+// Compiled with $(ISA_AVX2) = -mavx2 -mfma (see Makefile).
+#include "gemm_kernels_impl.h"
+
+const GemmKernel& gemm_kernel_avx2()
+{
+    static const GemmKernel k = make_kernel("avx2");
+    return k;
+}
@@ -0,0 +1,8 @@
+// Compiled with $(ISA_AVX512) = -mavx512f -mavx2 -mfma (see Makefile).
+#include "gemm_kernels_impl.h"
+
+const GemmKernel& gemm_kernel_avx512()
+{
+    static const GemmKernel k = make_kernel("avx512");
+    return k;
+}
@@ -0,0 +1,125 @@
+// ─────────────────────────────────────────────────────────────────────────────
+//  gemm_kernels_impl.h  –  the micro-kernel, included by exactly one
+//  gemm_kernels_<isa>.cpp
+//
+//  As in LAB3/kernels_impl.h, everything lives in an anonymous namespace so
+//  that no inline function compiled for AVX-512 can be picked by the linker
+//  for the whole program.
+//
+//  The tile is vectorised along j, the contiguous direction of row-major C:
+//  per k, NR / W vectors of B are loaded once and every row's A value is
+//  broadcast against them, so the MR × NR / W accumulators never leave the
+//  registers until the final C update.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "gemm_kernels.h"
+#include <immintrin.h>
+
+#ifndef __SSE2__
+#error "gemm_kernels_impl.h needs at least SSE2"
+#endif
+
+namespace {
+
+#if defined(__AVX512F__)
+
+struct V {
+    typedef __m512d reg;
+    enum { W = 8, MR = 8, NR = 24 };   // 24 accumulators + 3 B + 1 A of 32 zmm
+    static inline reg zero()                     { return _mm512_setzero_pd(); }
+    static inline reg load(const double* p)      { return _mm512_load_pd(p); }
+    static inline reg loadu(const double* p)     { return _mm512_loadu_pd(p); }
+    static inline reg set1(double x)             { return _mm512_set1_pd(x); }
+    static inline reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static inline void store(double* p, reg v)   { _mm512_store_pd(p, v); }
+    static inline void storeu(double* p, reg v)  { _mm512_storeu_pd(p, v); }
+};
+
+#elif defined(__AVX2__) && defined(__FMA__)
+
+struct V {
+    typedef __m256d reg;
+    enum { W = 4, MR = 6, NR = 8 };    // 12 accumulators + 2 B + 1 A of 16 ymm
+    static inline reg zero()                     { return _mm256_setzero_pd(); }
+    static inline reg load(const double* p)      { return _mm256_load_pd(p); }
+    static inline reg loadu(const double* p)     { return _mm256_loadu_pd(p); }
+    static inline reg set1(double x)             { return _mm256_set1_pd(x); }
+    static inline reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static inline void store(double* p, reg v)   { _mm256_store_pd(p, v); }
+    static inline void storeu(double* p, reg v)  { _mm256_storeu_pd(p, v); }
+};
+
+#else
+
+struct V {
+    typedef __m128d reg;
+    enum { W = 2, MR = 4, NR = 4 };    // 8 accumulators + 2 B + 1 A of 16 xmm
+    static inline reg zero()                     { return _mm_setzero_pd(); }
+    static inline reg load(const double* p)      { return _mm_load_pd(p); }
+    static inline reg loadu(const double* p)     { return _mm_loadu_pd(p); }
+    static inline reg set1(double x)             { return _mm_set1_pd(x); }
+    static inline reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static inline void store(double* p, reg v)   { _mm_store_pd(p, v); }
+    static inline void storeu(double* p, reg v)  { _mm_storeu_pd(p, v); }
+};
+
+#endif
+
+const int MR = V::MR, NR = V::NR, NV = V::NR / V::W;
+
+void ukernel(int kc, const double* a, const double* b,
+             double alpha, double* c, int ldc, int m, int n)
+{
+    V::reg acc[MR][NV];
+    for (int i = 0; i < MR; ++i)
+        for (int v = 0; v < NV; ++v)
+            acc[i][v] = V::zero();
+
+    for (int k = 0; k < kc; ++k) {
+        V::reg vb[NV];
+        for (int v = 0; v < NV; ++v)
+            vb[v] = V::load(b + k * NR + v * V::W);
+        for (int i = 0; i < MR; ++i) {
+            const V::reg va = V::set1(a[k * MR + i]);
+            for (int v = 0; v < NV; ++v)
+                acc[i][v] = V::fmadd(va, vb[v], acc[i][v]);
+        }
+    }
+
+    const V::reg va = V::set1(alpha);
+    if (m == MR && n == NR) {
+        for (int i = 0; i < MR; ++i)
+            for (int v = 0; v < NV; ++v) {
+                double* p = c + (long)i * ldc + v * V::W;
+                V::storeu(p, V::fmadd(va, acc[i][v], V::loadu(p)));
+            }
+        return;
+    }
+
+    // Edge tile: spill, then update only the m × n cells that exist.
+    alignas(64) double t[MR * NR];
+    for (int i = 0; i < MR; ++i)
+        for (int v = 0; v < NV; ++v)
+            V::store(t + i * NR + v * V::W, acc[i][v]);
+    for (int i = 0; i < m; ++i)
+        for (int j = 0; j < n; ++j)
+            c[(long)i * ldc + j] += alpha * t[i * NR + j];
+}
+
+// Blocks: an MC × KC block of A stays in L2 and a KC × NR micro-panel of
+// B in L1 while the micro-kernel sweeps the block; the KC × NC panel of B
+// is shared by the team from L3.
+GemmKernel make_kernel(const char* isa)
+{
+    GemmKernel k;
+    k.isa     = isa;
+    k.MR      = MR;
+    k.NR      = NR;
+    k.KC      = 256;
+    k.MC      = 192 / MR * MR;       // 192 × 256 doubles = 384 KB
+    k.NC      = 3072 / NR * NR;
+    k.ukernel = ukernel;
+    return k;
+}
+
+} // namespace
@@ -0,0 +1,8 @@
+// Compiled with $(ISA_SSE2) = -msse2 (see Makefile).
+#include "gemm_kernels_impl.h"
+
+const GemmKernel& gemm_kernel_sse2()
+{
+    static const GemmKernel k = make_kernel("sse2");
+    return k;
+}
@@ -0,0 +1,304 @@
+#include "gemm.h"
+#include "gemm_internal.h"
+#include <cstdio>
+#include <cstdlib>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  STRASSEN-WINOGRAD
+//
+//  One level on h × h quadrants (n = 2h), Winograd's form with 7 products
+//  and 15 additions:
+//
+//    S1 = A21 + A22   T1 = B12 - B11     M1 = A11 B11   M5 = S1 T1
+//    S2 = S1  - A11   T2 = B22 - T1      M2 = A12 B21   M6 = S2 T2
+//    S3 = A11 - A21   T3 = B22 - B12     M3 = S4  B22   M7 = S3 T3
+//    S4 = A12 - S2    T4 = T2  - B21     M4 = A22 T4
+//
+//    U2 = M1 + M6   U3 = U2 + M7
+//    C11 = M1 + M2        C12 = U2 + M5 + M3
+//    C21 = U3 - M4        C22 = U3 + M5
+//
+//  Sequential levels use the schedule of Boyer, Dumas, Pernet & Zhou
+//  ("Memory efficient scheduling of Strassen-Winograd's algorithm"), which
+//  builds the result in the C quadrants with only two h × h temporaries.
+//  With a team of more than one thread the top levels instead keep all of
+//  S1-S4, T1-T4 and M1, M6, M7 and run the 7 products as OpenMP tasks,
+//  each on its own slice of the arena.  Tasks nest down to the depth where
+//  there are about 4 per thread (7, 49, 343, ... products), so large teams
+//  stay busy and the uneven leaves balance; below that depth each task is
+//  a sequential recursion.  Those leaf tasks are tied and never yield, so
+//  each runs start to finish on one thread and their temporaries come
+//  from per-thread slices; every task level costs 11 h × h blocks of
+//  arena per node for its operands, so the workspace grows with the team.
+//
+//  Odd n recurse on n - 1 and add the last row / column of the product
+//  with three thin gemm() calls.  Sizes <= cutoff go to gemm_ws().
+// ─────────────────────────────────────────────────────────────────────────────
+
+// h × h blocks, rounded to a cache line so every slice stays 64-byte aligned.
+static size_t block(int h)
+{
+    return ((size_t)h * h + 7) / 8 * 8;
+}
+
+// Temporaries of a sequential recursion from size n: X and Y per level.
+static size_t seq_size(int n, int cutoff)
+{
+    size_t s = 0;
+    for (; n > cutoff; n /= 2)
+        s += 2 * block(n / 2);
+    return s;
+}
+
+// One task's slice: recursion temporaries, then gemm_ws() scratch for a
+// single thread at the largest leaf or peel it will see.
+static size_t task_size(int n, int cutoff)
+{
+    return seq_size(n, cutoff) + gemm_ws_size(n, n, n, 1);
+}
+
+// Task levels for a team of `threads` on even n > cutoff: at least one,
+// then more while the products number fewer than 4 per thread and the
+// halves are still even and above the cutoff.
+static int task_levels(int n, int cutoff, int threads)
+{
+    int  levels = 1;
+    long tasks  = 7;
+    for (n /= 2; tasks < 4L * threads && n > cutoff && n % 2 == 0; n /= 2, tasks *= 7)
+        ++levels;
+    return levels;
+}
+
+// S/T/M blocks of `levels` task levels from size n: 11 blocks per node
+// plus the 7 nodes of the level below.
+static size_t level_size(int n, int levels)
+{
+    if (levels == 0)
+        return 0;
+    const int h = n / 2;
+    return 11 * block(h) + 7 * level_size(h, levels - 1);
+}
+
+// Arena of a top-level call: gemm_ws() scratch alone below the cutoff, one
+// sequential slice, or the task levels plus the team's own gemm_ws()
+// scratch for the peel at the top.
+static size_t arena_size(int N, int cutoff, int threads)
+{
+    if (N <= cutoff)
+        return gemm_ws_size(N, N, N, threads);
+    if (threads <= 1)
+        return task_size(N, cutoff);
+    const int n = N & ~1, levels = task_levels(n, cutoff, threads);
+    return level_size(n, levels) + threads * task_size(n >> levels, cutoff)
+         + gemm_ws_size(N, N, N, threads);
+}
+
+// c = a + b and c = a - b on h × h blocks.
+static void add(int h, const double* a, int lda, const double* b, int ldb, double* c, int ldc)
+{
+    for (int i = 0; i < h; ++i)
+        for (int j = 0; j < h; ++j)
+            c[(long)i * ldc + j] = a[(long)i * lda + j] + b[(long)i * ldb + j];
+}
+
+static void sub(int h, const double* a, int lda, const double* b, int ldb, double* c, int ldc)
+{
+    for (int i = 0; i < h; ++i)
+        for (int j = 0; j < h; ++j)
+            c[(long)i * ldc + j] = a[(long)i * lda + j] - b[(long)i * ldb + j];
+}
+
+static void leaf(int M, int N, int K, const double* A, int lda, const double* B, int ldb,
+                 double beta, double* C, int ldc, double* gws, int threads)
+{
+    gemm_ws(Transpose::No, Transpose::No, M, N, K, 1.0, A, lda, B, ldb, beta, C, ldc, gws, threads);
+}
+
+// Last row and column of C = A · B for odd n, once C(0:n', 0:n') holds the
+// product of the leading n' = n - 1 blocks.
+static void peel(int n, const double* A, int lda, const double* B, int ldb,
+                 double* C, int ldc, double* gws, int threads)
+{
+    const int m = n - 1;
+    leaf(m, m, 1, A + m, lda, B + (long)m * ldb, ldb, 1.0, C, ldc, gws, threads);
+    leaf(m, 1, n, A, lda, B + m, ldb, 0.0, C + m, ldc, gws, threads);
+    leaf(1, n, n, A + (long)m * lda, lda, B, ldb, 0.0, C + (long)m * ldc, ldc, gws, threads);
+}
+
+// C = A · B on one thread; `ws` holds seq_size(n, cutoff) doubles, `gws`
+// the single-thread gemm_ws() scratch.
+static void strassen_seq(int n, const double* A, int lda, const double* B, int ldb,
+                         double* C, int ldc, int cutoff, double* ws, double* gws)
+{
+    if (n <= cutoff) {
+        leaf(n, n, n, A, lda, B, ldb, 0.0, C, ldc, gws, 1);
+        return;
+    }
+    if (n & 1) {
+        strassen_seq(n - 1, A, lda, B, ldb, C, ldc, cutoff, ws, gws);
+        peel(n, A, lda, B, ldb, C, ldc, gws, 1);
+        return;
+    }
+
+    const int h = n / 2;
+    const double *A11 = A, *A12 = A + h, *A21 = A + (long)h * lda, *A22 = A21 + h;
+    const double *B11 = B, *B12 = B + h, *B21 = B + (long)h * ldb, *B22 = B21 + h;
+    double *C11 = C, *C12 = C + h, *C21 = C + (long)h * ldc, *C22 = C21 + h;
+    double *X = ws, *Y = ws + block(h), *rest = ws + 2 * block(h);
+
+    sub(h, A11, lda, A21, lda, X, h);                                 // S3
+    sub(h, B22, ldb, B12, ldb, Y, h);                                 // T3
+    strassen_seq(h, X, h, Y, h, C21, ldc, cutoff, rest, gws);         // M7
+    add(h, A21, lda, A22, lda, X, h);                                 // S1
+    sub(h, B12, ldb, B11, ldb, Y, h);                                 // T1
+    strassen_seq(h, X, h, Y, h, C22, ldc, cutoff, rest, gws);         // M5
+    sub(h, X, h, A11, lda, X, h);                                     // S2
+    sub(h, B22, ldb, Y, h, Y, h);                                     // T2
+    strassen_seq(h, X, h, Y, h, C12, ldc, cutoff, rest, gws);         // M6
+    sub(h, A12, lda, X, h, X, h);                                     // S4
+    strassen_seq(h, X, h, B22, ldb, C11, ldc, cutoff, rest, gws);     // M3
+    strassen_seq(h, A11, lda, B11, ldb, X, h, cutoff, rest, gws);     // M1
+    add(h, X, h, C12, ldc, C12, ldc);                                 // U2 = M1 + M6
+    add(h, C12, ldc, C21, ldc, C21, ldc);                             // U3 = U2 + M7
+    add(h, C12, ldc, C22, ldc, C12, ldc);                             // U4 = U2 + M5
+    add(h, C21, ldc, C22, ldc, C22, ldc);                             // C22 = U3 + M5
+    add(h, C12, ldc, C11, ldc, C12, ldc);                             // C12 = U4 + M3
+    sub(h, Y, h, B21, ldb, Y, h);                                     // T4
+    strassen_seq(h, A22, lda, Y, h, C11, ldc, cutoff, rest, gws);     // M4
+    sub(h, C21, ldc, C11, ldc, C21, ldc);                             // C21 = U3 - M4
+    strassen_seq(h, A12, lda, B21, ldb, C11, ldc, cutoff, rest, gws); // M2
+    add(h, X, h, C11, ldc, C11, ldc);                                 // C11 = M1 + M2
+}
+
+// One task level on even n: S / T and the 7 products as tasks, each
+// product one level further down while `levels` lasts, then the combine
+// in row tasks.  Runs inside the team's single region; `ws` holds
+// level_size(n, levels) doubles and `leaves` one task_size(n >> levels)
+// slice per thread.
+static void strassen_level(int n, const double* A, int lda, const double* B, int ldb,
+                           double* C, int ldc, int cutoff, double* ws, int levels,
+                           double* leaves)
+{
+    const int h = n / 2;
+    const size_t bs = block(h), ts = level_size(h, levels - 1);
+    const double *A11 = A, *A12 = A + h, *A21 = A + (long)h * lda, *A22 = A21 + h;
+    const double *B11 = B, *B12 = B + h, *B21 = B + (long)h * ldb, *B22 = B21 + h;
+    double *C11 = C, *C12 = C + h, *C21 = C + (long)h * ldc, *C22 = C21 + h;
+    double *S1 = ws, *S2 = S1 + bs, *S3 = S2 + bs, *S4 = S3 + bs;
+    double *T1 = S4 + bs, *T2 = T1 + bs, *T3 = T2 + bs, *T4 = T3 + bs;
+    double *M1 = T4 + bs, *M6 = M1 + bs, *M7 = M6 + bs;
+    double* task = M7 + bs;
+
+    // Products: left operand, right operand, destination (M2-M5 go straight
+    // into the C quadrant they end up in, overwritten in the combine).
+    const double* l[7] = { A11, A12, S4, A22, S1, S2, S3 };
+    const double* r[7] = { B11, B21, B22, T4, T1, T2, T3 };
+    const int     ll[7] = { lda, lda, h, lda, h, h, h };
+    const int     rl[7] = { ldb, ldb, ldb, h, h, h, h };
+    double*       d[7] = { M1, C11, C12, C21, C22, M6, M7 };
+    const int     dl[7] = { h, ldc, ldc, ldc, ldc, h, h };
+
+#pragma omp task
+    {
+        add(h, A21, lda, A22, lda, S1, h);
+        sub(h, S1, h, A11, lda, S2, h);
+        sub(h, A12, lda, S2, h, S4, h);
+    }
+#pragma omp task
+    {
+        sub(h, B12, ldb, B11, ldb, T1, h);
+        sub(h, B22, ldb, T1, h, T2, h);
+        sub(h, T2, h, B21, ldb, T4, h);
+    }
+#pragma omp task
+    sub(h, A11, lda, A21, lda, S3, h);
+#pragma omp task
+    sub(h, B22, ldb, B12, ldb, T3, h);
+#pragma omp taskwait
+
+    for (int p = 0; p < 7; ++p) {
+        double* slice = task + p * ts;
+#pragma omp task firstprivate(p, slice)
+        {
+            if (levels > 1) {
+                strassen_level(h, l[p], ll[p], r[p], rl[p], d[p], dl[p], cutoff, slice,
+                               levels - 1, leaves);
+            } else {
+                double* mine = leaves + omp_get_thread_num() * task_size(h, cutoff);
+                strassen_seq(h, l[p], ll[p], r[p], rl[p], d[p], dl[p], cutoff,
+                             mine, mine + seq_size(h, cutoff));
+            }
+        }
+    }
+#pragma omp taskwait
+
+#pragma omp taskloop
+    for (int i = 0; i < h; ++i) {
+        double *c11 = C11 + (long)i * ldc, *c12 = C12 + (long)i * ldc;
+        double *c21 = C21 + (long)i * ldc, *c22 = C22 + (long)i * ldc;
+        const double *m1 = M1 + (long)i * h, *m6 = M6 + (long)i * h, *m7 = M7 + (long)i * h;
+        for (int j = 0; j < h; ++j) {
+            const double u2 = m1[j] + m6[j], u3 = u2 + m7[j], m5 = c22[j];
+            c11[j] = m1[j] + c11[j];
+            c12[j] = u2 + m5 + c12[j];
+            c21[j] = u3 - c21[j];
+            c22[j] = u3 + m5;
+        }
+    }
+}
+
+// Top levels on a team of `threads` > 1, n even and > cutoff.
+static void strassen_tasks(int n, const double* A, int lda, const double* B, int ldb,
+                           double* C, int ldc, int cutoff, double* ws, int threads)
+{
+    const int levels = task_levels(n, cutoff, threads);
+    double* leaves = ws + level_size(n, levels);
+#pragma omp parallel num_threads(threads)
+#pragma omp single
+    strassen_level(n, A, lda, B, ldb, C, ldc, cutoff, ws, levels, leaves);
+}
+
+size_t gemm_strassen_workspace(int N, int cutoff)
+{
+    if (N <= 0)
+        return 0;
+    return arena_size(N, cutoff > 0 ? cutoff : STRASSEN_CUTOFF, omp_get_max_threads());
+}
+
+void gemm_strassen(int N, const double* A, int lda,
+                   const double* B, int ldb,
+                   double* C, int ldc,
+                   int cutoff, double* workspace)
+{
+    if (N <= 0)
+        return;
+    if (cutoff <= 0)
+        cutoff = STRASSEN_CUTOFF;
+    const int threads = omp_get_max_threads();
+    const size_t size = arena_size(N, cutoff, threads);
+
+    double* ws = workspace;
+    if (!ws) {
+        ws = alloc_panel(size);
+        if (!ws) {
+            std::fprintf(stderr, "gemm: out of memory for the Strassen workspace\n");
+            return;
+        }
+    }
+
+    if (N <= cutoff) {
+        leaf(N, N, N, A, lda, B, ldb, 0.0, C, ldc, ws, threads);
+    } else if (threads <= 1) {
+        strassen_seq(N, A, lda, B, ldb, C, ldc, cutoff, ws, ws + seq_size(N, cutoff));
+    } else {
+        // The team's gemm_ws() scratch sits at the end of the arena.
+        double* gws = ws + size - gemm_ws_size(N, N, N, threads);
+        strassen_tasks(N & ~1, A, lda, B, ldb, C, ldc, cutoff, ws, threads);
+        if (N & 1)
+            peel(N, A, lda, B, ldb, C, ldc, gws, threads);
+    }
+
+    if (!workspace)
+        std::free(ws);
+}
@@ -0,0 +1,134 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <omp.h>
+#include "../common/matrix.h"
+#include "../common/transpose.h"
+
+using namespace std;
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Usage:
+//    ./transpose_bench [N] [--threads T] [--reps R]
+//
+//  Times the N × N transposes of additionallab.cpp, for double and float,
+//  against a STREAM-style copy of the same bytes (a[i] = b[i] over N²
+//  elements, the best a transpose could do):
+//
+//    copy                 STREAM Copy, parallel for, static schedule
+//    naive collapse(2)    BT(j, i) = B(i, j), the loop transpose() replaced
+//    transpose()          out of place, common/transpose.h
+//    transpose_inplace()  in place on one matrix
+//
+//  Every time is the best of R runs (default 10).  Bandwidth counts one
+//  read and one write per element, 2·N²·sizeof(T) bytes, as STREAM does
+//  for Copy, so the last column is the fraction of copy bandwidth reached.
+//  Each transpose is checked against the naive one before it is timed.
+//
+//  N          square size (default 4000; powers of two put every row of a
+//             leaf in the same cache sets, try 4096 to see it)
+//  --threads  OpenMP team size (default: system max)
+//  --reps     runs per measurement, best kept
+// ─────────────────────────────────────────────────────────────────────────────
+
+template <class F>
+static double best_of(int reps, F run) {
+    double best = 1e30;
+    for (int r = 0; r < reps; r++) {
+        const double start = omp_get_wtime();
+        run();
+        best = min(best, omp_get_wtime() - start);
+    }
+    return best;
+}
+
+static void report(const char* label, double t, double bytes, double t_copy) {
+    cout << label << fixed << setprecision(4) << t << "s  [" << setprecision(2) << setw(6)
+         << bytes / t * 1e-9 << " GB/s";
+    if (t_copy > 0)
+        cout << ", " << setprecision(2) << t_copy / t << "x copy";
+    cout << "]" << endl;
+}
+
+template <class T>
+static bool bench(const char* type, int N, int reps) {
+    Matrix<T> B(N, N), BT(N, N), R(N, N);
+    const size_t len = (size_t)N * B.stride();
+
+    // First touch by the team that uses them (static schedule, as below).
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < B.stride(); j++) {
+            B(i, j) = (T)((size_t)i * N + j);
+            BT(i, j) = R(i, j) = 0;
+        }
+
+    const double bytes = 2.0 * N * N * sizeof(T);
+    cout << "[" << type << ", " << fixed << setprecision(1) << bytes / 2 / 1048576.0
+         << " MiB per matrix]" << endl;
+
+    // STREAM Copy over the same N × stride elements.
+    T* a = BT.data();
+    const T* b = B.data();
+    const double t_copy = best_of(reps, [&] {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < len; i++)
+            a[i] = b[i];
+    });
+    report("copy:                 ", t_copy, bytes, 0);
+
+    const double t_naive = best_of(reps, [&] {
+        #pragma omp parallel for collapse(2)
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                R(j, i) = B(i, j);
+    });
+    report("naive collapse(2):    ", t_naive, bytes, t_copy);
+
+    bool ok = true;
+    transpose(B.view(), BT.view());
+    for (int i = 0; i < N && ok; i++)
+        ok = !memcmp(BT.row(i), R.row(i), N * sizeof(T));
+    const double t_out = best_of(reps, [&] { transpose(B.view(), BT.view()); });
+    report("transpose():          ", t_out, bytes, t_copy);
+
+    transpose_inplace(N, B.data(), B.stride());
+    for (int i = 0; i < N && ok; i++)
+        ok = !memcmp(B.row(i), R.row(i), N * sizeof(T));
+    const double t_in = best_of(reps, [&] { transpose_inplace(N, B.data(), B.stride()); });
+    report("transpose_inplace():  ", t_in, bytes, t_copy);
+
+    if (!ok)
+        cout << "transpose check: FAILED" << endl;
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    vector<int> dims;
+    int reps = 10;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--threads") && a + 1 < argc)
+            omp_set_num_threads(atoi(argv[++a]));
+        else if (!strcmp(argv[a], "--reps") && a + 1 < argc)
+            reps = atoi(argv[++a]);
+        else
+            dims.push_back(atoi(argv[a]));
+    }
+    const int N = dims.empty() ? 4000 : dims[0];
+    if (N <= 0 || reps <= 0 || dims.size() > 1) {
+        cerr << "Usage: " << argv[0] << " [N] [--threads T] [--reps R]" << endl;
+        return 1;
+    }
+
+    cout << "Matrix Size: " << N << "x" << N << endl;
+    cout << "Threads: " << omp_get_max_threads() << ", transpose ISA: " << transpose_isa() << endl;
+    cout << "------------------------------------------" << endl;
+    const bool ok_d = bench<double>("double", N, reps);
+    cout << "------------------------------------------" << endl;
+    const bool ok_f = bench<float>("float", N, reps);
+    return ok_d && ok_f ? 0 : 1;
+}
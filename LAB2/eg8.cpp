@@ -7,12 +7,12 @@
 // C++ Code: Cache Tiling Example
 
 #include <iostream>
-#include <vector>
 #include <omp.h>
 #include <chrono>
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
+#include "../common/matrix.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -20,26 +20,29 @@ using namespace std::chrono;
 const int N = 8192; 
 const int BLOCK_SIZE = 64; // Fits nicely in most L2 caches (64*64*8 bytes = 32KB)
 
-void process_standard(vector<double>& data) {
+void process_standard(Matrix<double>& data) {
     #pragma omp parallel for
     for (int i = 0; i < N; i++) {
+        double* row = data.row(i);
         for (int j = 0; j < N; j++) {
             // Simple row-major access
-            data[i * N + j] = sqrt(data[i * N + j]) * 1.01;
+            row[j] = sqrt(row[j]) * 1.01;
         }
     }
 }
 
-void process_with_tiling(vector<double>& data) {
+void process_with_tiling(Matrix<double>& data) {
     // collapse(2) merges the i and j loops into one large iteration space for better load balancing
     #pragma omp parallel for collapse(2) schedule(static)
     for (int i = 0; i < N; i += BLOCK_SIZE) {
         for (int j = 0; j < N; j += BLOCK_SIZE) {
             
-            // Inner loops process the small "tile"
-            for (int ii = i; ii < min(i + BLOCK_SIZE, N); ++ii) {
-                for (int jj = j; jj < min(j + BLOCK_SIZE, N); ++jj) {
-                    data[ii * N + jj] = sqrt(data[ii * N + jj]) * 1.01;
+            // Inner loops process the small "tile": a view into data, no copy
+            MatrixView<double> tile = data.block(i, j, min(BLOCK_SIZE, N - i), min(BLOCK_SIZE, N - j));
+            for (int ii = 0; ii < tile.rows(); ++ii) {
+                double* row = tile.row(ii);
+                for (int jj = 0; jj < tile.cols(); ++jj) {
+                    row[jj] = sqrt(row[jj]) * 1.01;
                 }
             }
         }
@@ -48,7 +51,9 @@ void process_with_tiling(vector<double>& data) {
 
 int main() {
     // 8192^2 doubles ≈ 536MB (Fits in RAM, but definitely not in Cache)
-    vector<double> data(N * N, 42.0);
+    // One 64-byte aligned allocation (common/matrix.h), rows N apart
+    Matrix<double> data(N, N);
+    data.fill(42.0);
     
     cout << "Comparing Standard vs Tiled Processing (" << N << "x" << N << ")" << endl;
     cout << "Block Size: " << BLOCK_SIZE << endl;
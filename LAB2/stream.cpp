@@ -0,0 +1,439 @@
+// STREAM memory bandwidth suite (after McCalpin's STREAM) in C++ / OpenMP
+// The four kernels, each a pass over arrays much larger than the caches:
+//   Copy   c[i] = a[i]                 2 words moved per iteration
+//   Scale  b[i] = s * c[i]             2
+//   Add    c[i] = a[i] + b[i]          3
+//   Triad  a[i] = b[i] + s * c[i]      3   (the kernel of eg7 / eg16)
+// Unlike eg7 / eg16, the arrays are first touched in parallel by the same
+// threads, with the same static split, that later run the kernels (so each
+// page sits on its reader's NUMA node), every kernel is repeated and the
+// first pass is thrown away as warm-up, and the results are checked.
+// Build: g++ -O3 -fopenmp stream.cpp -o stream
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <emmintrin.h>
+
+using namespace std;
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Usage:
+//    ./stream [N] [--ntimes K] [--threads T | --sweep] [--per-socket]
+//             [--stores normal|nt|all] [--json FILE]
+//
+//  N             elements per array (default: 4x the last-level cache in
+//                doubles, at least 10M, as STREAM's rule asks)
+//  --ntimes      passes per kernel, the first discarded (default 10)
+//  --threads     team size (default: system max)
+//  --sweep       team sizes 1, 2, 4, ... up to the max (and the max)
+//  --per-socket  also one run per NUMA node, with the team pinned to that
+//                node's CPUs and the arrays first-touched there
+//  --stores      normal: plain stores (each written line is read first, as
+//                write-allocate, and that traffic is not counted, as in
+//                STREAM); nt: non-temporal stores, which skip that read;
+//                all: both
+//  --json FILE   every run's figures as JSON, plus the best Triad rate as
+//                the bandwidth ceiling for a roofline
+//
+//  Threads are pinned one per CPU, in contiguous blocks per node (as
+//  LAB3/numa.cpp) unless OMP_PROC_BIND already binds them.  Rates are MB/s
+//  (10^6 bytes), from the best pass; times are in seconds.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const int    NKERNELS = 4;
+static const char*  NAMES[NKERNELS] = { "Copy", "Scale", "Add", "Triad" };
+static const int    WORDS[NKERNELS] = { 2, 2, 3, 3 };
+static const double SCALAR = 3.0;
+
+// ── Topology: node → CPUs from sysfs ──────────────────────────────────────────
+
+// "0-3,8,10-11" → {0, 1, 2, 3, 8, 10, 11}
+static vector<int> parse_list(const char* s) {
+    vector<int> out;
+    while (*s && *s != '\n') {
+        int lo = 0, hi = 0, used = 0;
+        if (sscanf(s, "%d-%d%n", &lo, &hi, &used) == 2) {
+            for (int c = lo; c <= hi; c++)
+                out.push_back(c);
+        } else if (sscanf(s, "%d%n", &lo, &used) == 1) {
+            out.push_back(lo);
+        } else {
+            break;
+        }
+        s += used;
+        if (*s == ',')
+            s++;
+    }
+    return out;
+}
+
+static bool read_line(const char* path, char* buf, int size) {
+    FILE* f = fopen(path, "r");
+    if (!f)
+        return false;
+    const bool ok = fgets(buf, size, f) != nullptr;
+    fclose(f);
+    return ok;
+}
+
+// CPUs of every node that has some (one node of all CPUs without sysfs)
+static vector<vector<int> > read_nodes() {
+    vector<vector<int> > nodes;
+    char buf[4096], path[128];
+    if (read_line("/sys/devices/system/node/online", buf, sizeof buf)) {
+        const vector<int> ids = parse_list(buf);
+        for (size_t n = 0; n < ids.size(); n++) {
+            snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", ids[n]);
+            if (!read_line(path, buf, sizeof buf))
+                continue;
+            const vector<int> cpus = parse_list(buf);
+            if (!cpus.empty())   // skip memory-only nodes
+                nodes.push_back(cpus);
+        }
+    }
+    if (nodes.empty()) {
+        nodes.resize(1);
+        for (int c = 0; c < (int)sysconf(_SC_NPROCESSORS_ONLN); c++)
+            nodes[0].push_back(c);
+    }
+    return nodes;
+}
+
+// Pin the calling team member: on `cpus` in turn, or with `cpus` empty,
+// contiguous blocks of the team per node.
+static void pin_thread(const vector<vector<int> >& nodes, const vector<int>& cpus) {
+    if (omp_get_proc_bind() != omp_proc_bind_false)
+        return;
+    const int me = omp_get_thread_num(), team = omp_get_num_threads();
+    int cpu;
+    if (!cpus.empty()) {
+        cpu = cpus[me % cpus.size()];
+    } else {
+        const int n = (int)nodes.size(), node = (int)((long long)me * n / team);
+        int first = 0;
+        while ((long long)first * n / team < node)
+            first++;
+        cpu = nodes[node][(me - first) % nodes[node].size()];
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    sched_setaffinity(0, sizeof set, &set);
+}
+
+// ── Arrays ────────────────────────────────────────────────────────────────────
+
+// Huge-page aligned and marked MADV_HUGEPAGE (as LAB3/aligned.cpp), so
+// the passes do not miss the TLB every 4 KB; pages are placed by the first
+// write, not here.
+static double* alloc_array(long n) {
+    const size_t HUGE = size_t(2) << 20;
+    const size_t bytes = ((size_t)n * sizeof(double) + HUGE - 1) / HUGE * HUGE;
+    void* p = nullptr;
+    if (posix_memalign(&p, HUGE, bytes) != 0)
+        return nullptr;
+#ifdef MADV_HUGEPAGE
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return (double*)p;
+}
+
+// This thread's share of [0, n), split on 64-byte lines so that no two
+// threads write the same line and every share starts aligned.
+static void thread_range(long n, long& lo, long& hi) {
+    const long lines = (n + 7) / 8;
+    const int  t = omp_get_thread_num(), team = omp_get_num_threads();
+    lo = min(n, lines * t / team * 8);
+    hi = min(n, lines * (t + 1) / team * 8);
+}
+
+// ── Kernels ───────────────────────────────────────────────────────────────────
+
+static void kernel(int k, double* __restrict a, double* __restrict b, double* __restrict c,
+                   long lo, long hi) {
+    switch (k) {
+    case 0: for (long i = lo; i < hi; i++) c[i] = a[i];                  break;
+    case 1: for (long i = lo; i < hi; i++) b[i] = SCALAR * c[i];         break;
+    case 2: for (long i = lo; i < hi; i++) c[i] = a[i] + b[i];           break;
+    case 3: for (long i = lo; i < hi; i++) a[i] = b[i] + SCALAR * c[i];  break;
+    }
+}
+
+// The same with _mm_stream_pd: 16-byte non-temporal stores (SSE2, so any
+// x86-64), which the write-combining buffers merge into whole lines.  lo
+// is line-aligned; the odd last element of the array goes through a
+// plain store.
+static void kernel_nt(int k, double* __restrict a, double* __restrict b, double* __restrict c,
+                      long lo, long hi) {
+    const __m128d s = _mm_set1_pd(SCALAR);
+    long i = lo;
+    switch (k) {
+    case 0:
+        for (; i + 2 <= hi; i += 2)
+            _mm_stream_pd(c + i, _mm_load_pd(a + i));
+        break;
+    case 1:
+        for (; i + 2 <= hi; i += 2)
+            _mm_stream_pd(b + i, _mm_mul_pd(s, _mm_load_pd(c + i)));
+        break;
+    case 2:
+        for (; i + 2 <= hi; i += 2)
+            _mm_stream_pd(c + i, _mm_add_pd(_mm_load_pd(a + i), _mm_load_pd(b + i)));
+        break;
+    case 3:
+        for (; i + 2 <= hi; i += 2)
+            _mm_stream_pd(a + i, _mm_add_pd(_mm_load_pd(b + i), _mm_mul_pd(s, _mm_load_pd(c + i))));
+        break;
+    }
+    if (i < hi)
+        kernel(k, a, b, c, i, hi);
+    _mm_sfence();
+}
+
+// ── One run: a team, a placement, a store kind ────────────────────────────────
+
+struct Stats {
+    double avg, min, max;   // seconds over passes 2..ntimes
+    double best_mbs;        // WORDS · 8 · n / min
+};
+
+struct Run {
+    int          threads;
+    int          node;      // -1: all nodes
+    bool         nt;
+    Stats        k[NKERNELS];
+    double       err;       // worst relative error of a, b, c (checked below)
+};
+
+// Expected a, b, c after `ntimes` rounds of the four kernels, from
+// a = 1, b = 2, c = 0, and the worst relative error of the arrays (means
+// of |x[i] - expected|, as STREAM's check).
+static double check(long n, int ntimes, const double* a, const double* b, const double* c) {
+    double aj = 1.0, bj = 2.0, cj = 0.0;
+    for (int k = 0; k < ntimes; k++) {
+        cj = aj;
+        bj = SCALAR * cj;
+        cj = aj + bj;
+        aj = bj + SCALAR * cj;
+    }
+    double ea = 0, eb = 0, ec = 0;
+    #pragma omp parallel for schedule(static) reduction(+ : ea, eb, ec)
+    for (long i = 0; i < n; i++) {
+        ea += fabs(a[i] - aj);
+        eb += fabs(b[i] - bj);
+        ec += fabs(c[i] - cj);
+    }
+    return max(max(ea / n / fabs(aj), eb / n / fabs(bj)), ec / n / fabs(cj));
+}
+
+static bool run(long n, int ntimes, const vector<vector<int> >& nodes, Run& r) {
+    double* a = alloc_array(n);
+    double* b = alloc_array(n);
+    double* c = alloc_array(n);
+    if (!a || !b || !c) {
+        cerr << "stream: cannot allocate 3 x " << n * sizeof(double) << " bytes" << endl;
+        free(a);
+        free(b);
+        free(c);
+        return false;
+    }
+    static const vector<int> any;
+    const vector<int>& cpus = r.node >= 0 ? nodes[r.node] : any;
+    vector<double> times((size_t)ntimes * NKERNELS);
+    double t0 = 0;
+
+    #pragma omp parallel num_threads(r.threads)
+    {
+        pin_thread(nodes, cpus);
+        long lo, hi;
+        thread_range(n, lo, hi);
+        for (long i = lo; i < hi; i++) {   // first touch, same split as below
+            a[i] = 1.0;
+            b[i] = 2.0;
+            c[i] = 0.0;
+        }
+        for (int p = 0; p < ntimes; p++)
+            for (int k = 0; k < NKERNELS; k++) {
+                #pragma omp single
+                t0 = omp_get_wtime();      // the barrier after it starts everyone together
+                if (r.nt)
+                    kernel_nt(k, a, b, c, lo, hi);
+                else
+                    kernel(k, a, b, c, lo, hi);
+                #pragma omp barrier
+                #pragma omp single
+                times[(size_t)p * NKERNELS + k] = omp_get_wtime() - t0;
+            }
+    }
+
+    for (int k = 0; k < NKERNELS; k++) {
+        Stats& s = r.k[k];
+        s.avg = 0;
+        s.min = 1e30;
+        s.max = 0;
+        for (int p = 1; p < ntimes; p++) {
+            const double t = times[(size_t)p * NKERNELS + k];
+            s.avg += t;
+            s.min = min(s.min, t);
+            s.max = max(s.max, t);
+        }
+        s.avg /= ntimes - 1;
+        s.best_mbs = WORDS[k] * sizeof(double) * (double)n / s.min * 1e-6;
+    }
+    r.err = check(n, ntimes, a, b, c);
+    free(a);
+    free(b);
+    free(c);
+    return true;
+}
+
+static string run_label(const Run& r) {
+    return to_string(r.threads) + (r.threads == 1 ? " thread" : " threads") + ", " +
+           (r.node >= 0 ? "node " + to_string(r.node) : string("all nodes")) + ", " +
+           (r.nt ? "nt" : "normal") + " stores";
+}
+
+static void print_run(const Run& r) {
+    cout << "[" << run_label(r) << "]" << endl;
+    cout << left << setw(10) << "Function" << right << setw(16) << "Best Rate MB/s"
+         << setw(12) << "Avg time" << setw(12) << "Min time" << setw(12) << "Max time" << endl;
+    for (int k = 0; k < NKERNELS; k++)
+        cout << left << setw(10) << (string(NAMES[k]) + ":") << right << fixed
+             << setprecision(1) << setw(16) << r.k[k].best_mbs << setprecision(6)
+             << setw(12) << r.k[k].avg << setw(12) << r.k[k].min << setw(12) << r.k[k].max << endl;
+    cout << "Validation: " << (r.err <= 1e-13 ? "PASSED" : "FAILED") << " (max rel err = "
+         << scientific << setprecision(2) << r.err << ")" << endl;
+    cout << string(62, '-') << endl;
+}
+
+static void json_run(ostream& o, const Run& r) {
+    o << "    {\"threads\": " << r.threads << ", \"node\": " << r.node << ", \"stores\": \""
+      << (r.nt ? "nt" : "normal") << "\", \"max_rel_err\": " << r.err << ", \"kernels\": {";
+    for (int k = 0; k < NKERNELS; k++) {
+        string name = NAMES[k];
+        transform(name.begin(), name.end(), name.begin(), ::tolower);
+        o << (k ? ",\n" : "\n") << "      \"" << name << "\": {\"bytes_per_iter\": "
+          << WORDS[k] * sizeof(double) << ", \"best_rate_mbs\": " << r.k[k].best_mbs
+          << ", \"avg_s\": " << r.k[k].avg << ", \"min_s\": " << r.k[k].min
+          << ", \"max_s\": " << r.k[k].max << "}";
+    }
+    o << "}}";
+}
+
+int main(int argc, char* argv[]) {
+    long n = 0;
+    int ntimes = 10;
+    int threads = omp_get_max_threads();
+    bool sweep = false, per_socket = false;
+    string stores = "normal";
+    const char* json = nullptr;
+    for (int a = 1; a < argc; a++) {
+        if (!strcmp(argv[a], "--ntimes") && a + 1 < argc)
+            ntimes = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--threads") && a + 1 < argc)
+            threads = atoi(argv[++a]);
+        else if (!strcmp(argv[a], "--sweep"))
+            sweep = true;
+        else if (!strcmp(argv[a], "--per-socket"))
+            per_socket = true;
+        else if (!strcmp(argv[a], "--stores") && a + 1 < argc)
+            stores = argv[++a];
+        else if (!strcmp(argv[a], "--json") && a + 1 < argc)
+            json = argv[++a];
+        else if (argv[a][0] != '-' && n == 0)
+            n = atol(argv[a]);
+        else
+            n = -1;
+    }
+    if (n == 0) {   // STREAM's rule: each array at least 4x the largest cache
+        const long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        n = max(10000000L, 4 * max(llc, 0L) / (long)sizeof(double));
+    }
+    if (n < 0 || ntimes < 2 || threads <= 0 ||
+        (stores != "normal" && stores != "nt" && stores != "all")) {
+        cerr << "Usage: " << argv[0] << " [N] [--ntimes K (>= 2)] [--threads T | --sweep]"
+             << " [--per-socket] [--stores normal|nt|all] [--json FILE]" << endl;
+        return 1;
+    }
+
+    const vector<vector<int> > nodes = read_nodes();
+    vector<bool> kinds;
+    if (stores != "nt")
+        kinds.push_back(false);
+    if (stores != "normal")
+        kinds.push_back(true);
+
+    // Team sizes on all nodes, then (per socket) each node's own CPUs.
+    vector<Run> runs;
+    vector<int> teams;
+    if (sweep) {
+        for (int t = 1; t < threads; t *= 2)
+            teams.push_back(t);
+    }
+    teams.push_back(threads);
+    for (bool nt : kinds) {
+        for (int t : teams) {
+            Run r = Run();
+            r.threads = t;
+            r.node = -1;
+            r.nt = nt;
+            runs.push_back(r);
+        }
+        if (per_socket)
+            for (int node = 0; node < (int)nodes.size(); node++) {
+                Run r = Run();
+                r.threads = (int)nodes[node].size();
+                r.node = node;
+                r.nt = nt;
+                runs.push_back(r);
+            }
+    }
+
+    cout << "STREAM: Copy, Scale, Add, Triad" << endl;
+    cout << "Array size: " << n << " elements, " << fixed << setprecision(1)
+         << n * sizeof(double) / 1048576.0 << " MiB per array, "
+         << 3 * n * sizeof(double) / 1048576.0 << " MiB total" << endl;
+    cout << "Passes per kernel: " << ntimes << " (best of the last " << ntimes - 1 << ")" << endl;
+    cout << "NUMA nodes: " << nodes.size() << ", max threads: " << omp_get_max_threads() << endl;
+    cout << string(62, '-') << endl;
+
+    bool ok = true;
+    double ceiling = 0;
+    for (Run& r : runs) {
+        if (!run(n, ntimes, nodes, r))
+            return 1;
+        print_run(r);
+        ok = ok && r.err <= 1e-13;
+        ceiling = max(ceiling, r.k[3].best_mbs);
+    }
+    cout << "Bandwidth ceiling (best Triad): " << fixed << setprecision(1) << ceiling
+         << " MB/s" << endl;
+
+    if (json) {
+        ofstream o(json);
+        if (!o) {
+            cerr << "Error: cannot write " << json << "." << endl;
+            return 1;
+        }
+        o << "{\"n\": " << n << ", \"ntimes\": " << ntimes << ", \"nodes\": " << nodes.size()
+          << ", \"triad_ceiling_mbs\": " << ceiling << ",\n  \"runs\": [";
+        for (size_t i = 0; i < runs.size(); i++) {
+            o << (i ? ",\n" : "\n");
+            json_run(o, runs[i]);
+        }
+        o << "\n  ]}\n";
+        cout << "Results -> " << json << " (" << runs.size() << " runs)" << endl;
+    }
+    return ok ? 0 : 1;
+}
\ No newline at end of file
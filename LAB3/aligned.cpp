@@ -0,0 +1,36 @@
+#include "aligned.h"
+#include <cstdlib>
+#include <cstring>
+#include <sys/mman.h>
+
+static bool hugepages_enabled()
+{
+    const char* env = std::getenv("CORRELATE_HUGEPAGES");
+    return !(env && !std::strcmp(env, "0"));
+}
+
+bool aligned_hugepages()
+{
+    static const bool on = hugepages_enabled();
+    return on;
+}
+
+void* aligned_malloc(size_t bytes)
+{
+    const bool   huge  = bytes >= HUGE_PAGE_BYTES && aligned_hugepages();
+    const size_t align = huge ? HUGE_PAGE_BYTES : BUFFER_ALIGN;
+    void* p = nullptr;
+    if (posix_memalign(&p, align, bytes ? bytes : 1) != 0)
+        throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    // Advisory only: without THP support this fails and nothing changes.
+    if (huge)
+        madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+void aligned_free(void* p)
+{
+    std::free(p);
+}
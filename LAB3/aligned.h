@@ -0,0 +1,76 @@
+#ifndef ALIGNED_H
+#define ALIGNED_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Aligned buffers for the LAB3 kernels.
+//
+//  Every buffer starts on a BUFFER_ALIGN boundary, so with row strides
+//  padded to the same multiple (padded_stride) every row of a normalised
+//  matrix starts aligned and the kernels use aligned, tail-free loads.
+//  Buffers of HUGE_PAGE_BYTES or more are aligned to a huge page and
+//  marked MADV_HUGEPAGE, so with THP in "madvise" (or "always") mode the
+//  kernel backs them with 2 MB pages and the tile loops stop missing the
+//  TLB.  CORRELATE_HUGEPAGES=0 turns the madvise off for A/B runs.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "../common/matrix.h"
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+const size_t BUFFER_ALIGN    = 64;
+const size_t HUGE_PAGE_BYTES = size_t(2) << 20;
+
+/** `bytes` of uninitialised memory as described above; throws std::bad_alloc. */
+void* aligned_malloc(size_t bytes);
+void  aligned_free(void* p);
+
+/** Whether large buffers are being marked MADV_HUGEPAGE. */
+bool aligned_hugepages();
+
+/**
+ * std::vector allocator on top of aligned_malloc.  Elements are
+ * default-initialised, i.e. resize() leaves floats and doubles unwritten:
+ * zero explicitly (assign) where it matters, and let the first writer of a
+ * page place it (see correlate_first_touch).
+ */
+template <class T>
+struct AlignedAllocator {
+    typedef T value_type;
+    template <class U> struct rebind { typedef AlignedAllocator<U> other; };
+
+    AlignedAllocator() {}
+    template <class U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n)          { return static_cast<T*>(aligned_malloc(n * sizeof(T))); }
+    void deallocate(T* p, size_t)  { aligned_free(p); }
+
+    template <class U> void construct(U* p) { ::new ((void*)p) U; }
+    template <class U, class... A> void construct(U* p, A&&... a) {
+        ::new ((void*)p) U(std::forward<A>(a)...);
+    }
+    template <class U> void destroy(U* p) { p->~U(); }
+};
+
+template <class T, class U>
+bool operator==(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const AlignedAllocator<T>&, const AlignedAllocator<U>&) { return false; }
+
+template <class T>
+using aligned_vector = std::vector<T, AlignedAllocator<T> >;
+
+/**
+ * Row-major matrix (common/matrix.h) on aligned_malloc, for the normalised
+ * rows: construct or reshape() with stride = padded_stride<T>(nx).
+ */
+struct AlignedStorage {
+    static void* allocate(size_t bytes) { return aligned_malloc(bytes); }
+    static void  deallocate(void* p)    { aligned_free(p); }
+};
+
+template <class T>
+using AlignedMatrix = Matrix<T, AlignedStorage>;
+
+#endif // ALIGNED_H
@@ -0,0 +1,180 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  BATCHED CORRELATION
+//
+//  correlate() on a 200 × 500 matrix spends a visible part of its time on
+//  the fork/join and on allocating and zero-filling the normalised copy.
+//  correlate_batch() opens one parallel region for the whole batch and
+//  runs the Task 4 tile kernels in two ways:
+//
+//    small jobs  whole job on one thread, handed out dynamically; rows are
+//                normalised into that thread's arena
+//    big jobs    the whole team on one job at a time (rows, then tiles),
+//                in one arena shared by the team
+//
+//  A job counts as big when it has enough tiles to keep every thread busy,
+//  or when there are fewer jobs than threads.  Threads run the small jobs
+//  first without waiting, so the big jobs start as soon as threads are
+//  free.  The per-thread arenas live in thread_local storage and the
+//  OpenMP threads persist, and the shared arena is thread_local to the
+//  calling thread, so after the first batch they are only resized when a
+//  larger job arrives.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const int BATCH_TILES_PER_THREAD = 4;
+
+namespace {
+template <class T>
+struct Arena {
+    aligned_vector<T>      norm;
+    aligned_vector<double> acc;
+};
+}
+
+template <class T>
+static Arena<T>& thread_arena()
+{
+    static thread_local Arena<T> a;
+    return a;
+}
+
+// The team-wide arena for big jobs, one per calling thread so batches
+// started from different application threads do not share it.
+template <class T>
+static aligned_vector<T>& shared_arena()
+{
+    static thread_local aligned_vector<T> norm;
+    return norm;
+}
+
+template <class T>
+static void grow(aligned_vector<T>& v, size_t n)
+{
+    if (v.size() < n)
+        v.resize(n);   // uninitialised: every element is written before use
+}
+
+// Tile t of the lower triangle of tile pairs, numbered row by row.
+static void tile_coords(int t, int& bi, int& bj)
+{
+    bi = (int)((std::sqrt(8.0 * t + 1.0) - 1.0) / 2.0);
+    while (bi * (bi + 1) / 2 > t)
+        --bi;
+    while ((bi + 1) * (bi + 2) / 2 <= t)
+        ++bi;
+    bj = t - bi * (bi + 1) / 2;
+}
+
+template <class T>
+static void normalise_job_row(const CorrelateJob& job, T* norm, int stride, int y)
+{
+    T* out = norm + (size_t)y * stride;
+    if (y < job.ny)
+        normalise_row(job.nx, job.data + (size_t)y * job.nx, out, stride);
+    else
+        std::fill(out, out + stride, T(0));   // padding rows of the last tile
+}
+
+template <class T>
+static void run_job_alone(const CorrelateJob& job,
+                          void (*tile)(const T*, const T*, int, int, double*))
+{
+    const int stride = padded_stride<T>(job.nx);
+    const int nt     = (job.ny + TILE - 1) / TILE;
+
+    Arena<T>& a = thread_arena<T>();
+    grow(a.norm, (size_t)nt * TILE * stride);
+    grow(a.acc, (size_t)TILE * TILE);
+
+    for (int y = 0; y < nt * TILE; ++y)
+        normalise_job_row(job, a.norm.data(), stride, y);
+
+    for (int bi = 0; bi < nt; ++bi)
+        for (int bj = 0; bj <= bi; ++bj)
+            run_tile(tile, a.norm.data(), stride, bi * TILE, bj * TILE,
+                     a.acc.data(), job.ny, job.result);
+}
+
+// Called by every thread of the team; `norm` is the shared arena.
+template <class T>
+static void run_job_shared(const CorrelateJob& job, T* norm,
+                           void (*tile)(const T*, const T*, int, int, double*))
+{
+    const int stride = padded_stride<T>(job.nx);
+    const int nt     = (job.ny + TILE - 1) / TILE;
+
+    Arena<T>& a = thread_arena<T>();
+    grow(a.acc, (size_t)TILE * TILE);
+
+#pragma omp for schedule(static)
+    for (int y = 0; y < nt * TILE; ++y)
+        normalise_job_row(job, norm, stride, y);
+
+    // The closing barrier also keeps the next big job from overwriting
+    // `norm` while tiles of this one are still running.
+#pragma omp for schedule(dynamic, 1)
+    for (int t = 0; t < nt * (nt + 1) / 2; ++t) {
+        int bi, bj;
+        tile_coords(t, bi, bj);
+        run_tile(tile, norm, stride, bi * TILE, bj * TILE, a.acc.data(), job.ny, job.result);
+    }
+}
+
+template <class T>
+static void batch_impl(const CorrelateJob* jobs, int njobs,
+                       void (*tile)(const T*, const T*, int, int, double*))
+{
+    const int threads = omp_get_max_threads();
+
+    std::vector<int> small, big;
+    size_t shared = 0;
+    for (int j = 0; j < njobs; ++j) {
+        if (jobs[j].ny <= 0 || jobs[j].nx <= 0)
+            continue;
+        const int nt     = (jobs[j].ny + TILE - 1) / TILE;
+        const int ntiles = nt * (nt + 1) / 2;
+        if (threads > 1 && (njobs < threads || ntiles >= BATCH_TILES_PER_THREAD * threads)) {
+            big.push_back(j);
+            shared = std::max(shared, (size_t)nt * TILE * padded_stride<T>(jobs[j].nx));
+        } else {
+            small.push_back(j);
+        }
+    }
+
+    aligned_vector<T>& norm = shared_arena<T>();
+    grow(norm, shared);
+    const int nsmall = (int)small.size();
+
+#pragma omp parallel
+    {
+#pragma omp for schedule(dynamic, 1) nowait
+        for (int s = 0; s < nsmall; ++s)
+            run_job_alone(jobs[small[s]], tile);
+
+        for (size_t b = 0; b < big.size(); ++b)
+            run_job_shared(jobs[big[b]], norm.data(), tile);
+    }
+}
+
+void correlate_batch(const CorrelateJob* jobs, int njobs, const CorrelateOptions& opt)
+{
+    const KernelTable& k = select_kernels();
+    switch (opt.precision) {
+    case Precision::Float:
+        batch_impl<float>(jobs, njobs, k.tile_f32);
+        break;
+    case Precision::Mixed:
+        batch_impl<float>(jobs, njobs, k.tile_f32_f64);
+        break;
+    case Precision::Double:
+    default:
+        batch_impl<double>(jobs, njobs, k.tile_f64);
+        break;
+    }
+}
@@ -0,0 +1,99 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  HARDWARE COUNTERS
+//
+//  `perf stat ./correlate` counts the whole process: fill_matrix, verify
+//  and the reference all land in the same totals.  These regions count
+//  only the phase they bracket, on the thread that runs it: every team
+//  member opens its own events (pid 0, any CPU) and reads them at the
+//  phase boundaries, so a region costs two read() calls per event.
+//
+//  Events are opened one by one, not as a group: six events exceed the
+//  general-purpose counters of most cores, and ungrouped events are
+//  time-multiplexed by the kernel instead of failing.  Each read carries
+//  the enabled and running times, and counts are scaled up by their
+//  ratio.  Kernel and hypervisor time are excluded, which is also what
+//  perf_event_paranoid = 2 allows an unprivileged user.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const uint64_t L1D_READ = PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8;
+static const struct { uint32_t type; uint64_t config; } EVENTS[COUNTER_EVENTS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, L1D_READ | (uint64_t)PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16 },
+    { PERF_TYPE_HW_CACHE, L1D_READ | (uint64_t)PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },   // last-level cache
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+};
+
+bool counters_open(ThreadCounters& c)
+{
+    c.on = true;
+    for (int e = 0; e < COUNTER_EVENTS; ++e) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof attr);
+        attr.size           = sizeof attr;
+        attr.type           = EVENTS[e].type;
+        attr.config         = EVENTS[e].config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        c.fd[e] = c.on ? (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0) : -1;
+        if (c.fd[e] < 0)
+            c.on = false;
+    }
+    if (!c.on)
+        counters_close(c);
+    return c.on;
+}
+
+void counters_close(ThreadCounters& c)
+{
+    for (int e = 0; e < COUNTER_EVENTS; ++e) {
+        if (c.fd[e] >= 0)
+            close(c.fd[e]);
+        c.fd[e] = -1;
+    }
+    c.on = false;
+}
+
+// Current totals, scaled for the time each event was not on a counter.
+static void read_counters(const ThreadCounters& c, double* v)
+{
+    for (int e = 0; e < COUNTER_EVENTS; ++e) {
+        uint64_t r[3] = { 0, 0, 0 };   // value, time enabled, time running
+        v[e] = 0.0;
+        if (read(c.fd[e], r, sizeof r) == (ssize_t)sizeof r && r[2] > 0)
+            v[e] = (double)r[0] * ((double)r[1] / (double)r[2]);
+    }
+}
+
+void phase_start(ThreadCounters& c)
+{
+    if (c.on)
+        read_counters(c, c.start);
+    c.t0 = omp_get_wtime();
+}
+
+void phase_stop(ThreadCounters& c, PhaseCounters& p)
+{
+    p.seconds += omp_get_wtime() - c.t0;
+    if (!c.on)
+        return;
+    double v[COUNTER_EVENTS];
+    read_counters(c, v);
+    p.cycles       += v[0] - c.start[0];
+    p.instructions += v[1] - c.start[1];
+    p.l1d_loads    += v[2] - c.start[2];
+    p.l1d_misses   += v[3] - c.start[3];
+    p.llc_refs     += v[4] - c.start[4];
+    p.llc_misses   += v[5] - c.start[5];
+}
@@ -0,0 +1,257 @@
+#include "distributed.h"
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  DISTRIBUTED — ring of row panels over MPI
+//
+//  The rows are cut into p panels, one per rank, so the ny × ny triangle is
+//  a p × p triangle of panel pairs.  Each rank normalises its own panel
+//  once; then the panels travel round the ring (rank r sends to r + 1 and
+//  receives from r - 1), and at step s rank r holds panel (r - s) mod p
+//  and computes the block of its own panel against it:
+//
+//    step 0          the diagonal block (r, r)
+//    steps 1 .. p/2  (r, r - s); pair (r, r - s) is (r - s, r) seen from
+//                    the other side, so p/2 steps cover every block once
+//                    (for even p, step p/2 reaches each pair from both
+//                    ends and only the lower half of the ranks takes it)
+//
+//  Every rank does ⌈(p + 1) / 2⌉ blocks or one fewer.  The next panel is
+//  received (MPI_Irecv / MPI_Isend) while the current one is computed, so
+//  the shift is hidden as long as one block takes longer than moving one
+//  panel; `wait` in DistributedStats is what was not hidden.  Blocks run
+//  on the Task 4 tile kernels with the rank's OpenMP team.
+//
+//  Results stay on their rank until the ring is done, then are either
+//  gathered on rank 0 or written in place into a shared file through
+//  MPI-IO: a block's rows are contiguous runs of the ny × ny output.
+// ─────────────────────────────────────────────────────────────────────────────
+
+int panel_begin(int ny, int ranks, int rank)
+{
+    const int nt = (ny + TILE - 1) / TILE;
+    return std::min(ny, (int)((long long)nt * rank / ranks) * TILE);
+}
+
+namespace {
+
+// One panel pair: rows of panel `lo` against rows of panel `hi`, lo <= hi,
+// stored as blk[(r - r0) * (rows of hi) + (c - c0)] = r(r, c), c >= r.
+struct Block {
+    int lo, hi;
+    size_t offset;   // into the rank's result buffer
+};
+
+// The blocks rank `r` computes, in ring order.
+std::vector<Block> blocks_of(int ny, int ranks, int r)
+{
+    std::vector<Block> out;
+    size_t offset = 0;
+    for (int s = 0; s <= ranks / 2; ++s) {
+        if (ranks % 2 == 0 && s == ranks / 2 && s > 0 && r >= ranks / 2)
+            continue;
+        const int v = (r - s + ranks) % ranks;
+        Block b;
+        b.lo     = std::min(r, v);
+        b.hi     = std::max(r, v);
+        b.offset = offset;
+        out.push_back(b);
+        offset += (size_t)(panel_begin(ny, ranks, b.lo + 1) - panel_begin(ny, ranks, b.lo))
+                * (panel_begin(ny, ranks, b.hi + 1) - panel_begin(ny, ranks, b.hi));
+    }
+    return out;
+}
+
+size_t block_floats(int ny, int ranks, const std::vector<Block>& blocks)
+{
+    if (blocks.empty())
+        return 0;
+    const Block& b = blocks.back();
+    return b.offset + (size_t)(panel_begin(ny, ranks, b.lo + 1) - panel_begin(ny, ranks, b.lo))
+                    * (panel_begin(ny, ranks, b.hi + 1) - panel_begin(ny, ranks, b.hi));
+}
+
+// r(r, c) for every row r of `lo` and c of `hi` (c >= r if lo == hi).
+void compute_block(const double* lo, int nlo, const double* hi, int nhi,
+                   int stride, bool diag, tile_f64_fn tile, float* blk)
+{
+    const int tlo = (nlo + TILE - 1) / TILE, thi = (nhi + TILE - 1) / TILE;
+    std::vector<int> tiles;   // (tile of lo, tile of hi)
+    for (int a = 0; a < tlo; ++a)
+        for (int b = diag ? a : 0; b < thi; ++b) {
+            tiles.push_back(a);
+            tiles.push_back(b);
+        }
+    const int ntiles = (int)tiles.size() / 2;
+
+#pragma omp parallel
+    {
+        aligned_vector<double> acc(TILE * TILE);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < ntiles; ++t) {
+            const int r0 = tiles[2 * t] * TILE, c0 = tiles[2 * t + 1] * TILE;
+            const bool same = diag && r0 == c0;
+            // acc[c * TILE + r]: the kernel fills r <= c on a diagonal tile.
+            tile(&hi[(size_t)c0 * stride], &lo[(size_t)r0 * stride], stride, same, acc.data());
+
+            const int rend = std::min(r0 + TILE, nlo), cend = std::min(c0 + TILE, nhi);
+            for (int r = r0; r < rend; ++r)
+                for (int c = same ? r : c0; c < cend; ++c)
+                    blk[(size_t)r * nhi + c] = clamp_r(acc[(c - c0) * TILE + (r - r0)]);
+        }
+    }
+}
+
+} // namespace
+
+bool correlate_distributed(MPI_Comm comm, int ny, int nx, const float* panel,
+                           float* result, const char* path, DistributedStats* stats)
+{
+    int ranks, rank;
+    MPI_Comm_size(comm, &ranks);
+    MPI_Comm_rank(comm, &rank);
+    DistributedStats st;
+
+    const int stride  = padded_stride<double>(nx);
+    const int nt      = (ny + TILE - 1) / TILE;
+    const int maxrows = (nt + ranks - 1) / ranks * TILE;
+    const int own     = panel_begin(ny, ranks, rank + 1) - panel_begin(ny, ranks, rank);
+    const tile_f64_fn tile = select_kernels().tile_f64;
+
+    // Own panel, and two ring buffers: one computed on, one being received.
+    double t0 = MPI_Wtime();
+    AlignedMatrix<double> mine(maxrows, nx, stride);
+    AlignedMatrix<double> ring[2];
+    for (int b = 0; b < 2; ++b) {
+        ring[b].reshape(maxrows, nx, stride);
+        ring[b].fill(0.0);
+    }
+    normalise_rows(own, nx, panel, mine.view());
+    st.normalise = MPI_Wtime() - t0;
+
+    const std::vector<Block> blocks = blocks_of(ny, ranks, rank);
+    std::vector<float> out(block_floats(ny, ranks, blocks));
+    const int left  = (rank - 1 + ranks) % ranks;
+    const int right = (rank + 1) % ranks;
+    const int steps = ranks / 2 + 1;
+
+    const double* cur = mine.data();
+    size_t next = 0;
+    for (int s = 0; s < steps; ++s) {
+        const int held = (rank - s + ranks) % ranks;
+        MPI_Request req[2];
+        int nreq = 0;
+        if (s + 1 < steps) {
+            const int from = (held - 1 + ranks) % ranks;   // what the left neighbour holds
+            const int rows_in  = panel_begin(ny, ranks, from + 1) - panel_begin(ny, ranks, from);
+            const int rows_out = panel_begin(ny, ranks, held + 1) - panel_begin(ny, ranks, held);
+            MPI_Irecv(ring[next].data(), rows_in * stride, MPI_DOUBLE, left, s, comm, &req[nreq++]);
+            MPI_Isend(cur, rows_out * stride, MPI_DOUBLE, right, s, comm, &req[nreq++]);
+            st.bytes += (double)rows_in * stride * sizeof(double);
+        }
+
+        t0 = MPI_Wtime();
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            if ((blocks[b].lo != std::min(rank, held)) || (blocks[b].hi != std::max(rank, held)))
+                continue;
+            const Block& blk = blocks[b];
+            const double* lo = (blk.lo == rank) ? mine.data() : cur;
+            const double* hi = (blk.hi == rank) ? mine.data() : cur;
+            compute_block(lo, panel_begin(ny, ranks, blk.lo + 1) - panel_begin(ny, ranks, blk.lo),
+                          hi, panel_begin(ny, ranks, blk.hi + 1) - panel_begin(ny, ranks, blk.hi),
+                          stride, blk.lo == blk.hi, tile, &out[blk.offset]);
+            ++st.blocks;
+        }
+        const double t1 = MPI_Wtime();
+        st.compute += t1 - t0;
+
+        MPI_Waitall(nreq, req, MPI_STATUSES_IGNORE);
+        st.wait += MPI_Wtime() - t1;
+        if (nreq) {
+            cur  = ring[next].data();
+            next = 1 - next;
+        }
+    }
+
+    // ── Output ───────────────────────────────────────────────────────────────
+    t0 = MPI_Wtime();
+    bool ok = true;
+    if (path) {
+        // Rank 0 creates the file at full size (and the .npy header); then
+        // every rank writes the rows of its blocks at their final offsets.
+        long long header = 0;
+        if (rank == 0) {
+            MappedMatrix m;
+            ok = create_matrix(path, ny, ny, m);
+            if (ok) {
+                header = (const char*)m.data - (const char*)m.base;
+                ok = unmap_matrix(m);
+            }
+        }
+        int flag = ok;
+        MPI_Bcast(&flag, 1, MPI_INT, 0, comm);
+        MPI_Bcast(&header, 1, MPI_LONG_LONG, 0, comm);
+        ok = flag != 0;
+
+        MPI_File fh;
+        if (ok && MPI_File_open(comm, path, MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS)
+            ok = false;   // same outcome on every rank: the open is collective
+        if (ok) {
+            for (size_t b = 0; b < blocks.size(); ++b) {
+                const Block& blk = blocks[b];
+                const int r0 = panel_begin(ny, ranks, blk.lo), r1 = panel_begin(ny, ranks, blk.lo + 1);
+                const int c0 = panel_begin(ny, ranks, blk.hi), c1 = panel_begin(ny, ranks, blk.hi + 1);
+                for (int r = r0; r < r1; ++r) {
+                    const int c = (blk.lo == blk.hi) ? r : c0;
+                    const MPI_Offset at = header + ((MPI_Offset)r * ny + c) * (MPI_Offset)sizeof(float);
+                    MPI_File_write_at(fh, at, &out[blk.offset + (size_t)(r - r0) * (c1 - c0) + (c - c0)],
+                                      c1 - c, MPI_FLOAT, MPI_STATUS_IGNORE);
+                }
+            }
+            MPI_File_close(&fh);
+        }
+    } else {
+        // Rank 0 knows every rank's block list, so the blocks travel as one
+        // flat buffer per rank and are unpacked by replaying the lists.
+        int count = (int)out.size();
+        std::vector<int> counts(ranks), displs(ranks);
+        MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, comm);
+        std::vector<float> all;
+        if (rank == 0) {
+            for (int q = 1; q < ranks; ++q)
+                displs[q] = displs[q - 1] + counts[q - 1];
+            all.resize((size_t)displs[ranks - 1] + counts[ranks - 1]);
+        }
+        MPI_Gatherv(out.data(), count, MPI_FLOAT, all.data(), counts.data(), displs.data(),
+                    MPI_FLOAT, 0, comm);
+
+        if (rank == 0) {
+            for (int q = 0; q < ranks; ++q) {
+                const std::vector<Block> theirs = blocks_of(ny, ranks, q);
+                const float* base = &all[displs[q]];
+                for (size_t b = 0; b < theirs.size(); ++b) {
+                    const Block& blk = theirs[b];
+                    const int r0 = panel_begin(ny, ranks, blk.lo), r1 = panel_begin(ny, ranks, blk.lo + 1);
+                    const int c0 = panel_begin(ny, ranks, blk.hi), c1 = panel_begin(ny, ranks, blk.hi + 1);
+                    for (int r = r0; r < r1; ++r) {
+                        const int c = (blk.lo == blk.hi) ? r : c0;
+                        std::memcpy(&result[c + (size_t)r * ny],
+                                    &base[blk.offset + (size_t)(r - r0) * (c1 - c0) + (c - c0)],
+                                    (size_t)(c1 - c) * sizeof(float));
+                    }
+                }
+            }
+        }
+    }
+    st.output = MPI_Wtime() - t0;
+
+    if (stats)
+        *stats = st;
+    return ok;
+}
@@ -0,0 +1,44 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Distributed correlation over MPI (distributed.cpp, built into
+//  correlate_mpi only: `make mpi`).  Kept out of functions.h so that the
+//  single-node binary neither needs mpi.h nor links libmpi.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include <mpi.h>
+
+/**
+ * Row panel of each rank: rank r of p owns rows [panel_begin(ny, p, r),
+ * panel_begin(ny, p, r + 1)).  Panels are whole TILE-row blocks, split as
+ * evenly as possible; a rank may own none when ny is small.
+ */
+int panel_begin(int ny, int ranks, int rank);
+
+/** Per-rank timings of one correlate_distributed() call (seconds). */
+struct DistributedStats {
+    double normalise = 0;   // own panel
+    double compute   = 0;   // tile kernels, all blocks
+    double wait      = 0;   // blocked in the ring shift (not hidden by compute)
+    double output    = 0;   // gather or file writes
+    int    blocks    = 0;   // panel pairs computed
+    double bytes     = 0;   // panel bytes received
+};
+
+/**
+ * Pearson correlation of the ny × nx matrix whose rows are spread over the
+ * ranks of `comm`: every rank passes only its own panel (rows
+ * panel_begin .. panel_begin(rank + 1), row-major).  Collective.
+ *
+ * The result is laid out as correlate()'s.  With `path` == nullptr it is
+ * gathered into `result` on rank 0 (ignored, may be nullptr, elsewhere);
+ * otherwise every rank writes its blocks straight into the file `path`
+ * (raw float32, or .npy by extension), which rank 0 creates.
+ *
+ * Returns false on every rank if the output file could not be created.
+ */
+bool correlate_distributed(MPI_Comm comm, int ny, int nx, const float* panel,
+                           float* result, const char* path, DistributedStats* stats);
+
+#endif // DISTRIBUTED_H
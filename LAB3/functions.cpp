@@ -1,47 +1,100 @@
 #include "functions.h"
+#include "functions_internal.h"
+#include "../common/transpose.h"
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <vector>
 #include <omp.h>
-#include <immintrin.h>   // AVX / SSE intrinsics
 
 // ─────────────────────────────────────────────────────────────────────────────
 //  INTERNAL HELPERS
 // ─────────────────────────────────────────────────────────────────────────────
 
+// One row through the fused SIMD kernel of the selected ISA (kernels_impl.h).
+void normalise_row(int nx, const float* row, double* out, int stride)
+{
+    select_kernels().normalise_f64(nx, row, out, stride);
+}
+
+void normalise_row(int nx, const float* row, float* out, int stride)
+{
+    select_kernels().normalise_f32(nx, row, out, stride);
+}
+
 /**
  * Normalise each row of `data` so that it has zero mean and unit length,
- * storing the result in `norm` (double precision).
- * Also used by all three implementation levels.
+ * storing the result in `norm`.  Statistics are always computed in double;
+ * T only selects the storage precision of the normalised copy.
+ * Also used by all implementation levels.
+ *
+ * Row y of the output is norm.row(y); the `stride - nx` padding elements
+ * after each row and any rows in [ny, norm.rows()) are zero-filled, so
+ * padded kernels can run over them without affecting the dot-products.
+ * Every element is written exactly once, so `norm` may come uninitialised.
  */
-static void normalise_rows(int ny, int nx,
-                            const float*  data,
-                            std::vector<double>& norm)
+template <class T>
+void normalise_rows(int ny, int nx,
+                    const float*  data,
+                    MatrixView<T> norm)
 {
-    norm.resize((size_t)ny * nx);
-
 #pragma omp parallel for schedule(static)
-    for (int y = 0; y < ny; ++y) {
-        // compute mean
-        double sum = 0.0;
-        for (int x = 0; x < nx; ++x)
-            sum += data[x + y * nx];
-        double mean = sum / nx;
-
-        // subtract mean
-        double sq = 0.0;
-        for (int x = 0; x < nx; ++x) {
-            double v = data[x + y * nx] - mean;
-            norm[x + y * nx] = v;
-            sq += v * v;
-        }
+    for (int y = 0; y < norm.rows(); ++y) {
+        if (y < ny)
+            normalise_row(nx, data + (size_t)y * nx, norm.row(y), norm.stride());
+        else
+            std::fill(norm.row(y), norm.row(y) + norm.stride(), T(0));
+    }
+}
+
+/**
+ * The same rows in the packed operand layout of the SYRK micro-kernel:
+ * panels of w rows, each stored k-major over the whole row,
+ *   out[(y / w) * w * nx + x * w + y % w]
+ * with rows up to the next multiple of w zero.  Values are rounded to T
+ * (the storage precision) and stored as C (the compute type), so Mixed
+ * keeps float-rounded rows but needs no widening later.
+ */
+template <class T, class C>
+void normalise_rows_packed(int ny, int nx,
+                           const float*  data,
+                           aligned_vector<C>& out,
+                           int w)
+{
+    // Resized, not assigned: a buffer reused at the same shape (plan.cpp)
+    // is neither reallocated nor refilled.  Only the padding rows of the
+    // last panel need zeros.
+    const int np = (ny + w - 1) / w;
+    if (out.size() != (size_t)np * w * nx)
+        out.resize((size_t)np * w * nx);
+
+#pragma omp parallel
+    {
+        aligned_vector<T> row(padded_stride<T>(nx));
 
-        // divide by L2-norm (guard against zero-variance rows)
-        double inv = (sq > 0.0) ? 1.0 / std::sqrt(sq) : 0.0;
-        for (int x = 0; x < nx; ++x)
-            norm[x + y * nx] *= inv;
+#pragma omp for schedule(static)
+        for (int p = 0; p < np; ++p) {
+            C* panel = &out[(size_t)p * w * nx];
+            for (int m = 0; m < w && p * w + m < ny; ++m) {
+                normalise_row(nx, data + (size_t)(p * w + m) * nx, row.data(), (int)row.size());
+                for (int x = 0; x < nx; ++x)
+                    panel[(size_t)x * w + m] = (C)row[x];
+            }
+            for (int m = ny - p * w; m < w; ++m)
+                for (int x = 0; x < nx; ++x)
+                    panel[(size_t)x * w + m] = C(0);
+        }
     }
 }
 
+template void normalise_rows<double>(int, int, const float*, MatrixView<double>);
+template void normalise_rows<float> (int, int, const float*, MatrixView<float>);
+template void normalise_rows_packed<double, double>(int, int, const float*, aligned_vector<double>&, int);
+template void normalise_rows_packed<float,  double>(int, int, const float*, aligned_vector<double>&, int);
+template void normalise_rows_packed<float,  float> (int, int, const float*, aligned_vector<float>&,  int);
+
 // ─────────────────────────────────────────────────────────────────────────────
 //  TASK 1 — Sequential baseline (double precision throughout)
 // ─────────────────────────────────────────────────────────────────────────────
@@ -50,15 +103,15 @@ static void correlate_sequential(int ny, int nx,
                                   float*       result)
 {
     // Step 1: normalise rows
-    std::vector<double> norm;
-    normalise_rows(ny, nx, data, norm);   // sequential-safe (single thread)
+    AlignedMatrix<double> norm;
+    normalise_rows(ny, nx, data, norm, ny);
 
     // Step 2: for each lower-triangular pair (i, j), dot-product gives r
     for (int i = 0; i < ny; ++i) {
         for (int j = 0; j <= i; ++j) {
             double dot = 0.0;
             for (int x = 0; x < nx; ++x)
-                dot += norm[x + i * nx] * norm[x + j * nx];
+                dot += norm(i, x) * norm(j, x);
             // clamp to [-1, 1] to absorb floating-point drift
             if (dot >  1.0) dot =  1.0;
             if (dot < -1.0) dot = -1.0;
@@ -69,95 +122,382 @@ static void correlate_sequential(int ny, int nx,
 
 // ─────────────────────────────────────────────────────────────────────────────
 //  TASK 2 — OpenMP multi-threaded (outer loop parallelised)
+//           The triangle is handed out by for_each_pair_tile (schedule.cpp),
+//           either as dynamic row chunks or as equal-work 2D tiles.
 // ─────────────────────────────────────────────────────────────────────────────
 static void correlate_openmp(int ny, int nx,
                               const float* data,
-                              float*       result)
+                              float*       result,
+                              Schedule     schedule,
+                              LoadStats*   load)
 {
-    std::vector<double> norm;
-    normalise_rows(ny, nx, data, norm);
+    AlignedMatrix<double> norm;
+    normalise_rows(ny, nx, data, norm, ny);
 
-#pragma omp parallel for schedule(dynamic, 16)
-    for (int i = 0; i < ny; ++i) {
-        for (int j = 0; j <= i; ++j) {
-            double dot = 0.0;
-            for (int x = 0; x < nx; ++x)
-                dot += norm[x + i * nx] * norm[x + j * nx];
-            if (dot >  1.0) dot =  1.0;
-            if (dot < -1.0) dot = -1.0;
-            result[i + j * ny] = (float)dot;
+    for_each_pair_tile(ny, schedule, [&](const TriTile& t) {
+        for (int i = t.i0; i < t.i1; ++i) {
+            const int jend = std::min(t.j1, i + 1);
+            for (int j = t.j0; j < jend; ++j) {
+                double dot = 0.0;
+                for (int x = 0; x < nx; ++x)
+                    dot += norm(i, x) * norm(j, x);
+                if (dot >  1.0) dot =  1.0;
+                if (dot < -1.0) dot = -1.0;
+                result[i + j * ny] = (float)dot;
+            }
         }
-    }
+    }, load);
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
-//  TASK 3 — OpenMP + AVX2 vectorised inner dot-product
-//           Falls back to scalar if AVX2 is unavailable at compile time.
+//  TASK 3 — OpenMP + SIMD vectorised inner dot-product
+//           The dot-product comes from the per-ISA kernel table, so it runs
+//           as SSE2, AVX2 or AVX-512 depending on the CPU (see kernels.h).
+//           Rows are padded to whole aligned vectors, so it needs no tail.
 // ─────────────────────────────────────────────────────────────────────────────
+static void correlate_vectorised(int ny, int nx,
+                                  const float* data,
+                                  float*       result,
+                                  Schedule     schedule,
+                                  LoadStats*   load)
+{
+    AlignedMatrix<double> norm;
+    normalise_rows(ny, nx, data, norm, ny);
+    const int stride = norm.stride();
 
-#ifdef __AVX2__
+    double (*dot_simd)(const double*, const double*, int) = select_kernels().dot_f64;
 
-// Horizontal sum of a 256-bit AVX double register (4 × double)
-static inline double hsum_avx(__m256d v) {
-    __m128d lo = _mm256_castpd256_pd128(v);
-    __m128d hi = _mm256_extractf128_pd(v, 1);
-    __m128d s  = _mm_add_pd(lo, hi);
-    return _mm_cvtsd_f64(_mm_hadd_pd(s, s));
+    for_each_pair_tile(ny, schedule, [&](const TriTile& t) {
+        for (int i = t.i0; i < t.i1; ++i) {
+            const double* ri = norm.row(i);
+            const int jend = std::min(t.j1, i + 1);
+            for (int j = t.j0; j < jend; ++j) {
+                const double* rj = norm.row(j);
+                double dot = dot_simd(ri, rj, stride);
+                if (dot >  1.0) dot =  1.0;
+                if (dot < -1.0) dot = -1.0;
+                result[i + j * ny] = (float)dot;
+            }
+        }
+    }, load);
 }
 
-static double dot_avx(const double* a, const double* b, int n) {
-    __m256d acc = _mm256_setzero_pd();
-    int x = 0;
-    for (; x <= n - 4; x += 4) {
-        __m256d va = _mm256_loadu_pd(a + x);
-        __m256d vb = _mm256_loadu_pd(b + x);
-        acc = _mm256_fmadd_pd(va, vb, acc);   // FMA if available
+// ─────────────────────────────────────────────────────────────────────────────
+//  TASK 4 — Register-blocked, cache-tiled kernel
+//
+//  Task 3 streams both rows from memory for every (i, j) pair.  Here the
+//  lower triangle is cut into TILE × TILE blocks of row pairs, and each block
+//  is computed by a per-ISA tile kernel (kernels_impl.h) as MR × NR
+//  micro-tiles whose accumulators stay in SIMD registers, walking x in
+//  panels small enough for the block's rows to stay in L1/L2.
+//
+//  This driver owns normalisation, padding and the OpenMP loop over tiles;
+//  T is the storage type of the normalised rows (double, or float for the
+//  Mixed and Float precisions).
+//
+//  In NUMA mode (numa.cpp) the team is pinned and every node gets its own
+//  copy of the normalised rows, written — and so first-touched — by that
+//  node's threads, so the tile kernels' operand reads never cross the
+//  socket link.  The copies cost nodes × ny × stride of memory and one
+//  extra O(ny · nx) normalisation per node, against O(ny² · nx) reads.
+//
+//  Both phases run in one parallel region, so that with `counters` set
+//  every thread can bracket its own share of each (counters.cpp).
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Flops per element of the fused normalise kernel: Welford's update (sub,
+// FMA, sub, FMA) in pass 1, centre and scale in pass 2.
+static const double NORMALISE_FLOPS = 8.0;
+
+template <class T>
+static void correlate_blocked(int ny, int nx,
+                               const float* data,
+                               float*       result,
+                               void (*tile)(const T*, const T*, int, int, double*),
+                               bool          numa,
+                               LoadStats*    load,
+                               CounterStats* counters)
+{
+    // Pad x to whole SIMD vectors and y to whole tiles, so that neither the
+    // micro-kernel nor the tile loops need any edge handling.
+    const int stride = padded_stride<T>(nx);
+    const int nt     = (ny + TILE - 1) / TILE;
+    const int rows   = nt * TILE;
+
+    // Pages untouched until the normalise loop below writes them.
+    AlignedMatrix<T> norm;
+    std::vector<AlignedMatrix<T> > replica;   // NUMA mode, one per node
+    if (numa)
+        replica.resize(correlate_numa_nodes());
+    else
+        norm.reshape(rows, nx, stride);
+
+    // Lower-triangular list of (I, J) tile pairs, J <= I.
+    std::vector<int> tiles;
+    for (int bi = 0; bi < nt; ++bi)
+        for (int bj = 0; bj <= bi; ++bj) {
+            tiles.push_back(bi);
+            tiles.push_back(bj);
+        }
+    const int ntiles = (int)tiles.size() / 2;
+
+    if (load) {
+        const int threads = omp_get_max_threads();
+        load->active.assign(threads, 0.0);
+        load->items.assign(threads, 0);
+        load->stolen.assign(threads, 0);
+        load->node.assign(threads, 0);
+        load->bytes.assign(threads, 0.0);
+    }
+    std::vector<char> opened;
+    if (counters) {
+        const int threads = omp_get_max_threads();
+        counters->normalise.assign(threads, PhaseCounters());
+        counters->dot.assign(threads, PhaseCounters());
+        opened.assign(threads, 0);
     }
-    double dot = hsum_avx(acc);
-    for (; x < n; ++x)                         // handle tail
-        dot += a[x] * b[x];
-    return dot;
+    std::vector<int> node_of(omp_get_max_threads(), 0);
+    const double start = omp_get_wtime();
+
+#pragma omp parallel
+    {
+        const int    me = omp_get_thread_num();
+        const double t0 = omp_get_wtime();
+        const T*     base = norm.data();
+
+        ThreadCounters hw;
+        if (counters) {
+            opened[me] = counters_open(hw);
+            phase_start(hw);
+        }
+        int normalised = 0;
+
+        if (numa) {
+            const int node = numa_pin_thread();
+            node_of[me] = node;
+#pragma omp barrier
+#pragma omp single
+            for (size_t n = 0; n < replica.size(); ++n)
+                if (std::count(node_of.begin(), node_of.end(), (int)n))
+                    replica[n].reshape(rows, nx, stride);   // pages untouched
+
+            // Split this node's copy over this node's threads.
+            int rank = 0, peers = 0;
+            for (int t = 0; t < omp_get_num_threads(); ++t)
+                if (node_of[t] == node) {
+                    rank  += (t < me);
+                    peers += 1;
+                }
+            AlignedMatrix<T>& own = replica[node];
+            for (int y = rank; y < rows; y += peers) {
+                if (y < ny) {
+                    normalise_row(nx, data + (size_t)y * nx, own.row(y), stride);
+                    ++normalised;
+                } else {
+                    std::fill(own.row(y), own.row(y) + stride, T(0));
+                }
+            }
+            base = own.data();
+        } else {
+            node_of[me] = numa_current_node();
+#pragma omp for schedule(static) nowait
+            for (int y = 0; y < rows; ++y) {
+                if (y < ny) {
+                    normalise_row(nx, data + (size_t)y * nx, norm.row(y), stride);
+                    ++normalised;
+                } else {
+                    std::fill(norm.row(y), norm.row(y) + stride, T(0));
+                }
+            }
+        }
+        if (counters) {
+            PhaseCounters& p = counters->normalise[me];
+            phase_stop(hw, p);
+            p.flops = NORMALISE_FLOPS * normalised * nx;
+            p.bytes = (double)normalised * (nx * sizeof(float) + stride * sizeof(T));
+        }
+#pragma omp barrier
+        if (counters)
+            phase_start(hw);
+
+        std::vector<double> acc(TILE * TILE);
+        int    items = 0;
+        double bytes = 0, flops = 0;
+
+#pragma omp for schedule(dynamic, 1) nowait
+        for (int t = 0; t < ntiles; ++t) {
+            const int i0 = tiles[2 * t] * TILE;
+            const int j0 = tiles[2 * t + 1] * TILE;
+            const bool diag = (i0 == j0);
+            run_tile(tile, base, stride, i0, j0, acc.data(), ny, result);
+            ++items;
+            bytes += (diag ? 1.0 : 2.0) * TILE * stride * sizeof(T);
+            flops += (diag ? TILE * (TILE + 1.0) : 2.0 * TILE * TILE) * stride;
+        }
+
+        if (counters) {
+            PhaseCounters& p = counters->dot[me];
+            phase_stop(hw, p);
+            p.flops = flops;
+            p.bytes = bytes;
+            counters_close(hw);
+        }
+        if (load) {
+            load->active[me] = omp_get_wtime() - t0;
+            load->items[me]  = items;
+            load->node[me]   = node_of[me];
+            load->bytes[me]  = bytes;
+        }
+        if (numa)
+            numa_unpin_thread();
+    }
+    if (load)
+        load->wall = omp_get_wtime() - start;
+    if (counters)
+        counters->available = std::count(opened.begin(), opened.end(), 0) == 0;
 }
 
-#endif // __AVX2__
+// ─────────────────────────────────────────────────────────────────────────────
+//  CPU DISPATCH
+//  This file is compiled for the baseline ISA; the wide kernels are only
+//  reached through the table picked here.
+// ─────────────────────────────────────────────────────────────────────────────
+static int isa_rank(const char* name) {
+    if (!std::strcmp(name, "avx512")) return 2;
+    if (!std::strcmp(name, "avx2"))   return 1;
+    if (!std::strcmp(name, "sse2"))   return 0;
+    return -1;
+}
 
-static void correlate_vectorised(int ny, int nx,
-                                  const float* data,
-                                  float*       result)
+static const KernelTable& detect_kernels()
 {
-    std::vector<double> norm;
-    normalise_rows(ny, nx, data, norm);
+    // __builtin_cpu_supports reads cpuid and also checks (via xgetbv) that
+    // the OS saves the wide registers, so a "yes" here is safe to execute.
+    __builtin_cpu_init();
+    int best = 0;
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        best = 1;
+    if (best == 1 && __builtin_cpu_supports("avx512f"))
+        best = 2;
 
-#pragma omp parallel for schedule(dynamic, 16)
-    for (int i = 0; i < ny; ++i) {
-        const double* ri = &norm[i * nx];
-        for (int j = 0; j <= i; ++j) {
-            const double* rj = &norm[j * nx];
-            double dot = 0.0;
-
-#ifdef __AVX2__
-            dot = dot_avx(ri, rj, nx);
-#else
-            for (int x = 0; x < nx; ++x)
-                dot += ri[x] * rj[x];
-#endif
-            if (dot >  1.0) dot =  1.0;
-            if (dot < -1.0) dot = -1.0;
-            result[i + j * ny] = (float)dot;
+    int level = best;
+    const char* env = std::getenv("CORRELATE_ISA");
+    if (env && *env) {
+        int forced = isa_rank(env);
+        if (forced < 0) {
+            std::fprintf(stderr, "correlate: ignoring unknown CORRELATE_ISA=%s\n", env);
+        } else if (forced > best) {
+            std::fprintf(stderr, "correlate: CORRELATE_ISA=%s not supported by this "
+                                 "CPU, using the best available level\n", env);
+        } else {
+            level = forced;
         }
     }
+
+    switch (level) {
+    case 2:  return kernels_avx512();
+    case 1:  return kernels_avx2();
+    default: return kernels_sse2();
+    }
+}
+
+const KernelTable& select_kernels()
+{
+    static const KernelTable& k = detect_kernels();
+    return k;
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  AUTO SELECTION
+//  Below AUTO_SEQ_WORK multiply-adds the OpenMP fork/join costs more than the
+//  whole computation.  The blocked kernel pads ny up to whole TILE-row
+//  blocks and hands out one tile per task, so it only pays off once there
+//  are more tiles than threads; until then the row-pair kernel balances
+//  better.  From AUTO_SYRK_ROWS rows on, the packed SYRK's higher FMA rate
+//  outweighs its packing cost (crossover measured at ny ≈ 500-1000).
+// ─────────────────────────────────────────────────────────────────────────────
+static const double AUTO_SEQ_WORK  = 1 << 16;
+static const int    AUTO_SYRK_ROWS = 768;
+
+Impl correlate_auto_impl(int ny, int nx, int num_threads)
+{
+    const double work   = 0.5 * ny * (ny + 1.0) * nx;
+    const int    nt     = (ny + TILE - 1) / TILE;
+    const int    ntiles = nt * (nt + 1) / 2;
+
+    if (work < AUTO_SEQ_WORK)
+        return Impl::Sequential;
+    if (ny < TILE || ntiles < num_threads)
+        return Impl::Vectorised;
+    if (ny >= AUTO_SYRK_ROWS)
+        return Impl::Syrk;
+    return Impl::Blocked;
 }
 
 // ─────────────────────────────────────────────────────────────────────────────
 //  PUBLIC ENTRY POINT
-//  Dispatches to the fastest available implementation (Task 3).
-//  To test sequential (Task 1) or OpenMP-only (Task 2), change the call below.
+//  Runs the implementation chosen in CorrelateOptions (Impl::Auto by
+//  default); Task 4 runs at the requested precision, using the kernels for
+//  the best ISA this CPU supports.
 // ─────────────────────────────────────────────────────────────────────────────
 void correlate(int ny, int nx, const float* data, float* result)
 {
-    correlate_vectorised(ny, nx, data, result);
+    correlate(ny, nx, data, result, CorrelateOptions());
+}
 
-    // Uncomment one of the lines below to test the other variants:
-    // correlate_sequential(ny, nx, data, result);
-    // correlate_openmp(ny, nx, data, result);
+void correlate(int ny, int nx, const float* data, float* result,
+               const CorrelateOptions& opt)
+{
+    if (opt.missing) {
+        correlate_pairwise(ny, nx, data, result);
+        return;
+    }
+
+    Impl impl = opt.impl;
+    if (impl == Impl::Auto)
+        impl = correlate_auto_impl(ny, nx, omp_get_max_threads());
+
+    switch (impl) {
+    case Impl::Sequential:
+        correlate_sequential(ny, nx, data, result);
+        return;
+    case Impl::OpenMP:
+        correlate_openmp(ny, nx, data, result, opt.schedule, opt.load);
+        return;
+    case Impl::Vectorised:
+        correlate_vectorised(ny, nx, data, result, opt.schedule, opt.load);
+        return;
+    case Impl::Syrk:
+        correlate_syrk(ny, nx, data, result, opt.precision);
+        return;
+    default:
+        break;
+    }
+
+    const KernelTable& k = select_kernels();
+    switch (opt.precision) {
+    case Precision::Float:
+        correlate_blocked<float>(ny, nx, data, result, k.tile_f32, opt.numa, opt.load, opt.counters);
+        break;
+    case Precision::Mixed:
+        correlate_blocked<float>(ny, nx, data, result, k.tile_f32_f64, opt.numa, opt.load, opt.counters);
+        break;
+    case Precision::Double:
+    default:
+        correlate_blocked<double>(ny, nx, data, result, k.tile_f64, opt.numa, opt.load, opt.counters);
+        break;
+    }
+}
+
+void correlate_columns(int ny, int nx, const float* data, float* result,
+                       const CorrelateOptions& opt)
+{
+    aligned_vector<float> cols((size_t)nx * ny);
+    transpose(ny, nx, data, nx, cols.data(), ny);
+    correlate(nx, ny, cols.data(), result, opt);
+}
+
+const char* correlate_isa()
+{
+    return select_kernels().name;
 }
\ No newline at end of file
@@ -0,0 +1,427 @@
+#ifndef FUNCTIONS_H
+#define FUNCTIONS_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+/**
+ * Arithmetic precision of the correlation kernel.
+ *
+ * Row statistics (mean, norm) are always computed in double; the precision
+ * selects how the normalised rows are stored and how dot-products are
+ * accumulated.
+ */
+enum class Precision {
+    Double,   // double storage, double accumulation (reference accuracy)
+    Mixed,    // float storage, double accumulation (half the bandwidth)
+    Float     // float storage, float accumulation  (2x the SIMD lanes)
+};
+
+/**
+ * Which implementation correlate() runs.  All variants produce the same
+ * result layout; only Blocked and Syrk honour CorrelateOptions::precision,
+ * the others always compute in double.
+ */
+enum class Impl {
+    Auto,         // pick from ny, nx and the OpenMP thread count (see below)
+    Sequential,   // Task 1: single-threaded scalar loops
+    OpenMP,       // Task 2: outer loop over rows parallelised
+    Vectorised,   // Task 3: OpenMP + SIMD dot-product per row pair
+    Blocked,      // Task 4: register-blocked, cache-tiled SIMD kernel
+    Syrk          // Task 5: normalise + packed blocked SYRK (N · Nᵀ)
+};
+
+/**
+ * How Tasks 2 and 3 hand out the lower triangle.  Row i holds i + 1 pairs,
+ * so equal-sized row chunks are not equal work.
+ */
+enum class Schedule {
+    Dynamic,    // schedule(dynamic, 16) over rows: one shared counter
+    Triangle    // equal-work 2D tiles dealt out up front, then work stealing
+};
+
+/**
+ * Per-thread load balance of one correlate() call (Tasks 2-4), measured as
+ * in LAB2/eg11.cpp: a thread is active from entering the parallel region
+ * until it finds no more work, and idle (waiting at the closing barrier)
+ * for the rest of the region's wall time.
+ */
+struct LoadStats {
+    double              wall = 0.0;   // seconds, whole parallel region
+    std::vector<double> active;       // seconds, per thread
+    std::vector<int>    items;        // rows (Dynamic) or tiles (Triangle, Task 4) run
+    std::vector<int>    stolen;       // tiles taken from another thread's deque
+    std::vector<int>    node;         // NUMA node the thread ran on
+    std::vector<double> bytes;        // normalised-row bytes fed to the Task 4 tiles
+};
+
+/**
+ * One thread's share of one phase of a Task 4 correlate() call.  The
+ * hardware counts are read in-process (perf_event_open on the thread,
+ * user space only, scaled if the kernel multiplexed them); flops and
+ * bytes are the work the phase's kernels were handed, not measured.
+ */
+struct PhaseCounters {
+    double seconds      = 0.0;
+    double cycles       = 0.0;
+    double instructions = 0.0;
+    double l1d_loads    = 0.0;
+    double l1d_misses   = 0.0;
+    double llc_refs     = 0.0;
+    double llc_misses   = 0.0;
+    double flops        = 0.0;
+    double bytes        = 0.0;   // input read + rows written (normalise), operand rows (dot)
+};
+
+/**
+ * Per-thread counters of the two phases of a Task 4 call (counters.cpp):
+ * normalising the rows, and the tile dot-products.  `available` is false
+ * when perf_event_open was refused (no PMU, perf_event_paranoid); the
+ * seconds, flops and bytes are filled regardless.
+ */
+struct CounterStats {
+    bool                       available = false;
+    std::vector<PhaseCounters> normalise;   // per thread
+    std::vector<PhaseCounters> dot;         // per thread
+};
+
+/**
+ * Tuning knobs for correlate().  Default-constructed options reproduce the
+ * behaviour of the four-argument overload.
+ *
+ * With `missing` set, NaN inputs are missing observations and every pair
+ * uses only the columns where both rows are present (pairwise-complete
+ * Pearson, in double, nan.cpp); pairs sharing fewer than two such columns
+ * get NaN.  The other options are ignored in that mode.
+ */
+struct CorrelateOptions {
+    Precision     precision = Precision::Double;
+    Impl          impl      = Impl::Auto;
+    Schedule      schedule  = Schedule::Triangle;   // Tasks 2 and 3 only
+    LoadStats*    load      = nullptr;              // if set, filled by Tasks 2-4
+    bool          numa      = false;                // Task 4: pin + per-node row copies
+    bool          missing   = false;                // NaN = missing value, see below
+    CounterStats* counters  = nullptr;              // if set, filled by Task 4
+};
+
+/**
+ * Compute pairwise Pearson correlation coefficients between all row-pairs
+ * of the input matrix.
+ *
+ * @param ny     Number of rows (vectors)
+ * @param nx     Number of columns (elements per vector)
+ * @param data   Input matrix stored row-major: data[x + y*nx]
+ * @param result Output matrix (ny x ny), stored row-major.
+ *               For all 0 <= j <= i < ny, result[i + j*ny] holds the
+ *               Pearson correlation between row i and row j.
+ */
+void correlate(int ny, int nx, const float* data, float* result);
+
+/**
+ * As above, with explicit options (see CorrelateOptions).
+ */
+void correlate(int ny, int nx, const float* data, float* result,
+               const CorrelateOptions& opt);
+
+/**
+ * Correlations between the nx columns instead (observations in rows,
+ * variables in columns): result is nx x nx in correlate()'s layout with
+ * nx for ny.  The columns are transposed into rows first (the parallel,
+ * cache-oblivious transpose of common/transpose.h) and then go through
+ * correlate() with `opt`.
+ */
+void correlate_columns(int ny, int nx, const float* data, float* result,
+                       const CorrelateOptions& opt = CorrelateOptions());
+
+/** One independent problem for correlate_batch(); fields as for correlate(). */
+struct CorrelateJob {
+    int          ny;
+    int          nx;
+    const float* data;
+    float*       result;
+};
+
+/**
+ * Run `njobs` independent correlate() problems in one parallel region
+ * (batch.cpp).  Small jobs run whole on one thread each, big ones on the
+ * whole team, and normalisation scratch is reused between jobs and calls.
+ * Always uses the Task 4 kernel at opt.precision; the other options are
+ * ignored.
+ */
+void correlate_batch(const CorrelateJob* jobs, int njobs,
+                     const CorrelateOptions& opt = CorrelateOptions());
+
+/**
+ * correlate() prepared once for one ny × nx shape (plan.cpp), after FFTW's
+ * plans: creation resolves Impl::Auto, picks the kernel for this CPU, lays
+ * out the tile schedule and allocates all scratch for opt.precision and
+ * the current omp_get_max_threads(); each execute then runs without
+ * allocating.  Plans use the Blocked or Syrk kernel; any other impl is
+ * planned as Blocked, and opt.schedule / load / numa are ignored.  A plan
+ * must not be executed by two threads at once.  create returns nullptr for
+ * an empty shape.
+ */
+struct CorrelatePlan;
+CorrelatePlan* correlate_plan_create(int ny, int nx,
+                                     const CorrelateOptions& opt = CorrelateOptions());
+void correlate_plan_execute(CorrelatePlan* plan, const float* data, float* result);
+Impl correlate_plan_impl(const CorrelatePlan* plan);
+void correlate_plan_destroy(CorrelatePlan* plan);
+
+/**
+ * One finished block of the result, as delivered by correlate_streaming().
+ * Cells use correlate()'s layout restricted to the block:
+ *   r[(i - i0) + (j - j0) * ni]  for i0 <= i < i0 + ni, j0 <= j < j0 + nj
+ * holds the correlation between rows i and j.  Blocks with i0 == j0 sit on
+ * the diagonal and only their cells with j <= i are defined.  `r` is only
+ * valid for the duration of the sink call.
+ */
+struct ResultTile {
+    int i0, j0;
+    int ni, nj;
+    const float* r;
+};
+
+typedef std::function<void(const ResultTile&)> TileSink;
+
+/**
+ * Out-of-core options.  The budget covers the normalised row panels, the
+ * block buffer and per-thread scratch; panels shrink to fit it, down to a
+ * minimum of one 48-row tile.
+ */
+struct StreamingOptions {
+    size_t    memory_budget = size_t(1) << 30;   // bytes
+    Precision precision     = Precision::Double;
+};
+
+/**
+ * Compute the lower triangle block by block with bounded memory, calling
+ * `sink` once per finished block (from the calling thread, in order of
+ * increasing i0, then j0).  `data` is read a row panel at a time, so it can
+ * be a memory-mapped file larger than RAM.
+ */
+void correlate_streaming(int ny, int nx, const float* data,
+                         const TileSink& sink,
+                         const StreamingOptions& opt = StreamingOptions());
+
+/**
+ * File-to-file out-of-core run.  `input_path` holds ny x nx raw float32
+ * values (row-major, as `data` above) and is memory-mapped; the result is
+ * written to `output_path` as a dense ny x ny float32 file in correlate()'s
+ * layout, with only the j <= i cells written.  Returns false (after
+ * printing the reason to stderr) on any I/O error.
+ */
+bool correlate_file(const char* input_path, int ny, int nx,
+                    const char* output_path,
+                    const StreamingOptions& opt = StreamingOptions());
+
+/**
+ * A float32 matrix file mapped into memory (matrix_io.cpp).  The format
+ * follows the extension:
+ *   *.npy   NumPy format, dtype '<f4', C order, shape (ny, nx)
+ *   other   raw ny x nx float32 values, row-major (as correlate_file)
+ * `data` points into the mapping itself, so inputs are used and results
+ * written in place, with no copy through the heap.
+ */
+struct MappedMatrix {
+    int    ny       = 0;
+    int    nx       = 0;
+    float* data     = nullptr;
+    void*  base     = nullptr;   // whole mapping, header included
+    size_t bytes    = 0;
+    bool   writable = false;
+};
+
+/**
+ * Map `path` read-only.  Raw files take their shape from ny and nx; .npy
+ * files from the header, which must then agree with any non-zero ny / nx.
+ * With `populate` every page is read in before returning (MAP_POPULATE),
+ * so the disk time is paid here rather than inside correlate().  Returns
+ * false after printing the reason to stderr.
+ */
+bool map_matrix(const char* path, int ny, int nx, bool populate, MappedMatrix& m);
+
+/**
+ * Create (or truncate) `path` as an ny x nx float32 matrix file of the
+ * format its extension selects, zero-filled, and map it read-write:
+ * correlate(..., m.data) then writes its result straight into the file.
+ */
+bool create_matrix(const char* path, int ny, int nx, MappedMatrix& m);
+
+/** Unmap `m`, first flushing a writable mapping to disk; false on error. */
+bool unmap_matrix(MappedMatrix& m);
+
+// ── Compact output formats (all built on correlate_streaming) ───────────────
+
+/** Offset of r(i, j), j <= i, in packed lower-triangular storage. */
+inline size_t packed_index(int i, int j)
+{
+    return (size_t)i * (i + 1) / 2 + j;
+}
+
+/**
+ * Packed lower triangle, diagonal included: packed[packed_index(i, j)] for
+ * 0 <= j <= i < ny, i.e. ny * (ny + 1) / 2 floats instead of ny * ny.
+ */
+void correlate_packed(int ny, int nx, const float* data, float* packed,
+                      const StreamingOptions& opt = StreamingOptions());
+
+/**
+ * Strict lower triangle in CSR form, keeping only |r| > threshold.  Row i
+ * owns entries [row_ptr[i], row_ptr[i + 1]) of col / val, with columns
+ * j < i in ascending order; (i, col[e], val[e]) is the COO view.
+ */
+struct SparseCorrelation {
+    std::vector<size_t> row_ptr;   // ny + 1 offsets
+    std::vector<int>    col;
+    std::vector<float>  val;
+};
+
+void correlate_threshold(int ny, int nx, const float* data, float threshold,
+                         SparseCorrelation& out,
+                         const StreamingOptions& opt = StreamingOptions());
+
+/**
+ * For every row i, its k strongest correlations by |r| with the other rows
+ * (both j < i and j > i), strongest first: partner index[i * k + e] with
+ * value[i * k + e].  Unused slots (ny - 1 < k) hold index -1.
+ */
+struct TopK {
+    int                k = 0;
+    std::vector<int>   index;
+    std::vector<float> value;
+};
+
+void correlate_topk(int ny, int nx, const float* data, int k, TopK& out,
+                    const StreamingOptions& opt = StreamingOptions());
+
+// ── Approximate threshold search (lsh.cpp) ──────────────────────────────────
+
+/**
+ * Banded SimHash over `tables` × `bits` sign random projections.  Two rows
+ * at angle θ (r = cos θ) share a band with probability p = (1 - θ/π)^bits,
+ * or that of the negated row, so a pair is found with probability about
+ * 1 - (1 - p)^tables.  More tables raise recall; more bits per table cut
+ * the candidates (and the time) but lower recall.  bits = 0 takes
+ * lsh_bits(ny), which grows with ny so that buckets stay small; at
+ * ny = 20000 that is 12 bits, where 32 tables find > 99% of the pairs at
+ * |r| = 0.9 while checking ~1.5% of uncorrelated ones.  Larger ny gets
+ * more bits and needs more tables for the same recall.
+ */
+struct LshOptions {
+    int      bits   = 0;    // per table, 1..32; 0: lsh_bits(ny)
+    int      tables = 32;
+    unsigned seed   = 1;
+};
+
+/**
+ * Default bits per table for ny rows: the fewest for which the expected
+ * bucket, ny / 2^(bits - 1) canonical bands, holds at most 16 rows, so
+ * a table yields O(16 · ny) candidates rather than O(ny²).
+ */
+int lsh_bits(int ny);
+
+/**
+ * Approximate correlate_threshold(): the same CSR output, holding only
+ * pairs with |r| > threshold, but built from the candidate pairs that
+ * share a SimHash bucket rather than from all ny² / 2.  Every reported
+ * value is exact (the candidates are verified against the normalised
+ * rows), so precision is 1 and misses are the only error.  Returns the
+ * number of candidate pairs verified.
+ */
+size_t correlate_approx(int ny, int nx, const float* data, float threshold,
+                        SparseCorrelation& out, const LshOptions& opt = LshOptions());
+
+// ── Rank correlations (rank.cpp) ────────────────────────────────────────────
+
+/**
+ * Replace every row of `data` by its ranks 1..nx in `ranks` (same layout);
+ * tied values get the mean of the ranks they span.  Rows run in parallel.
+ */
+void rank_rows(int ny, int nx, const float* data, float* ranks);
+
+/**
+ * Spearman's ρ: Pearson's r of the ranked rows, computed by correlate()
+ * with `opt`.  Result layout as for correlate().
+ */
+void correlate_spearman(int ny, int nx, const float* data, float* result,
+                        const CorrelateOptions& opt = CorrelateOptions());
+
+/**
+ * Kendall's τ_b (tie-corrected) between every pair of rows, O(nx log nx)
+ * per pair.  Result layout as for correlate(); constant rows give 0.
+ */
+void correlate_kendall(int ny, int nx, const float* data, float* result);
+
+// ── Incremental engine (incremental.cpp) ────────────────────────────────────
+
+/**
+ * Running state for a matrix that grows by columns (new samples) or rows
+ * (new series) without recomputing everything: per-row means and the
+ * packed lower triangle of pairwise co-moments
+ *   comoment[packed_index(i, j)] = Σ_x (x_i - mean_i) · (x_j - mean_j)
+ * (the diagonal holds each row's sum of squared deviations).  The raw
+ * values are kept as well, since a new row must be crossed with every old
+ * one.
+ */
+struct IncrementalCorrelation {
+    int ny = 0;
+    int nx = 0;
+    std::vector<std::vector<float> > rows;       // ny rows of nx raw values
+    std::vector<double>              mean;       // ny
+    std::vector<double>              comoment;   // ny * (ny + 1) / 2
+};
+
+/** Start from an ny x nx matrix (layout as for correlate()): O(ny² · nx). */
+void incremental_init(IncrementalCorrelation& s, int ny, int nx, const float* data);
+
+/**
+ * Append k columns to every row; cols[y * k + c] is row y's c-th new value.
+ * O(ny² · k), merged in with Chan et al.'s pairwise update (Welford's
+ * update when k == 1), so no sums of raw products ever accumulate.
+ */
+void incremental_append_columns(IncrementalCorrelation& s, int k, const float* cols);
+
+/** Append one row of s.nx values as row s.ny: O(ny · nx). */
+void incremental_append_row(IncrementalCorrelation& s, const float* row);
+
+/** Current correlations in correlate()'s layout (result is ny x ny): O(ny²). */
+void incremental_result(const IncrementalCorrelation& s, float* result);
+
+/**
+ * The implementation Impl::Auto resolves to for an ny x nx input run on
+ * `num_threads` OpenMP threads.  Never returns Impl::Auto.
+ */
+Impl correlate_auto_impl(int ny, int nx, int num_threads);
+
+/**
+ * What Impl::Syrk runs on: "built-in" (the packed SYRK in syrk.cpp) or
+ * "cblas" when built with USE_BLAS=1.
+ */
+const char* correlate_syrk_backend();
+
+/**
+ * NUMA nodes that have CPUs, from /sys/devices/system/node (1 if unknown).
+ * With CorrelateOptions::numa the OpenMP team is pinned in contiguous
+ * blocks, thread t to node t * nodes / num_threads, unless OMP_PROC_BIND
+ * already binds it.
+ */
+int correlate_numa_nodes();
+
+/**
+ * Zero-fill `rows` x `cols` floats at `p` from the pinned OpenMP team, one
+ * static block of rows per thread, so that an untouched buffer's pages are
+ * placed on the nodes whose threads own those rows (Linux first-touch).
+ * Pins the calling team as NUMA mode does.
+ */
+void correlate_first_touch(float* p, size_t rows, size_t cols);
+
+/**
+ * Instruction-set level the kernels were dispatched to on this CPU:
+ * "sse2", "avx2" or "avx512".  Chosen once via cpuid; the CORRELATE_ISA
+ * environment variable can force a lower level for A/B testing.
+ */
+const char* correlate_isa();
+
+#endif // FUNCTIONS_H
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef FUNCTIONS_INTERNAL_H
+#define FUNCTIONS_INTERNAL_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Helpers shared by the LAB3 translation units that are compiled for the
+//  baseline ISA (functions.cpp, streaming.cpp, ...).  Not for the
+//  kernels_<isa>.cpp objects, which must not instantiate std templates.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "aligned.h"
+#include "functions.h"
+#include "kernels.h"
+#include <algorithm>
+#include <vector>
+
+// Row stride, in elements of T, padded to a whole ROW_ALIGN_BYTES vector.
+template <class T>
+inline int padded_stride(int nx)
+{
+    const int per_vec = ROW_ALIGN_BYTES / (int)sizeof(T);
+    return (nx + per_vec - 1) / per_vec * per_vec;
+}
+
+/**
+ * Normalise rows to zero mean and unit length (defined in functions.cpp for
+ * T = double and T = float) into the first ny rows of `norm`, whose stride
+ * must be padded_stride<T>(nx).  The padding after each row and rows
+ * [ny, norm.rows()) are zero.  Rows are written in parallel (static
+ * schedule), so an uninitialised `norm` is first touched by the team.
+ */
+template <class T>
+void normalise_rows(int ny, int nx,
+                    const float*  data,
+                    MatrixView<T> norm);
+
+// The same into `norm` reshaped to rows × nx, reallocated only if it grows.
+template <class T>
+inline void normalise_rows(int ny, int nx,
+                           const float*      data,
+                           AlignedMatrix<T>& norm,
+                           int rows)
+{
+    norm.reshape(rows, nx, padded_stride<T>(nx));
+    normalise_rows(ny, nx, data, norm.view());
+}
+
+// One row of the above: nx values from `row` into out[0, stride), through
+// the fused SIMD kernel of the selected ISA.
+void normalise_row(int nx, const float* row, double* out, int stride);
+void normalise_row(int nx, const float* row, float*  out, int stride);
+
+/**
+ * Normalised rows in the SYRK's packed layout: panels of w rows, k-major,
+ *   out[(y / w) * w * nx + x * w + y % w]
+ * rounded to T and stored as C (T = C, or T = float, C = double for Mixed).
+ */
+template <class T, class C>
+void normalise_rows_packed(int ny, int nx,
+                           const float*  data,
+                           aligned_vector<C>& out,
+                           int w);
+
+/**
+ * counters.cpp: hardware counters of the calling thread.  counters_open()
+ * returns false (and leaves only the clock running) if the kernel refuses
+ * any of the events; phase_start() / phase_stop() bracket one phase and
+ * add its seconds and counts to `p`.  The same thread must open, use and
+ * close a set.
+ */
+const int COUNTER_EVENTS = 6;
+struct ThreadCounters {
+    int    fd[COUNTER_EVENTS];
+    bool   on = false;
+    double t0 = 0.0;
+    double start[COUNTER_EVENTS];
+};
+bool counters_open(ThreadCounters& c);
+void counters_close(ThreadCounters& c);
+void phase_start(ThreadCounters& c);
+void phase_stop(ThreadCounters& c, PhaseCounters& p);
+
+// numa.cpp: call from inside a parallel region.  numa_pin_thread() binds
+// the calling team member (see correlate_numa_nodes) and returns its node;
+// numa_unpin_thread() restores the mask it replaced, and must be called
+// before the region ends so the caller's affinity is left as it was.
+int numa_pin_thread();
+void numa_unpin_thread();
+int numa_current_node();
+
+// Task 5 (syrk.cpp): normalise, then a packed, blocked SYRK into `result`.
+void correlate_syrk(int ny, int nx, const float* data, float* result, Precision prec);
+
+/**
+ * CorrelateOptions::missing (nan.cpp): pairwise-complete r over the columns
+ * where neither row is NaN: Σab from the Task 4 tile kernels, the other sums
+ * corrected on the mask words with gaps only.
+ */
+void correlate_pairwise(int ny, int nx, const float* data, float* result);
+
+/**
+ * Task 5 scratch: the packed rows (a), the shared B panel (b) and the
+ * per-thread C blocks (c) of each compute type.  Buffers are sized on
+ * first use and only resized when the shape or team changes, so repeated
+ * calls on one workspace do not allocate.
+ */
+struct SyrkWorkspace {
+    aligned_vector<double> a64, b64, c64;
+    aligned_vector<float>  a32, b32, c32;
+};
+void correlate_syrk(int ny, int nx, const float* data, float* result, Precision prec,
+                    SyrkWorkspace& ws);
+void syrk_workspace_reserve(int ny, int nx, Precision prec, SyrkWorkspace& ws);
+
+/**
+ * A rectangle of the lower triangle: rows [i0, i1) × columns [j0, j1),
+ * of which only the pairs with j <= i are to be computed.
+ */
+struct TriTile {
+    int i0, i1;
+    int j0, j1;
+};
+
+/**
+ * Run `body` over tiles that together cover every pair j <= i < n exactly
+ * once, on the current OpenMP team (schedule.cpp).  Fills `load` if set.
+ */
+void for_each_pair_tile(int n, Schedule schedule,
+                        const std::function<void(const TriTile&)>& body,
+                        LoadStats* load);
+
+// Clamp a dot-product of unit vectors to [-1, 1] to absorb floating-point drift.
+inline float clamp_r(double dot)
+{
+    if (dot >  1.0) dot =  1.0;
+    if (dot < -1.0) dot = -1.0;
+    return (float)dot;
+}
+
+/**
+ * Task 4 tile (i0, j0) of the ny × ny result: run the tile kernel on the
+ * normalised rows `norm` (TILE-padded, stride `stride`) into the TILE ×
+ * TILE scratch `acc`, then clamp and store the pairs that exist, i < ny
+ * and j <= i on a diagonal tile (j < ny off it), at result[i + j * ny].
+ * The one copy of this edge handling for every tile-list driver.
+ */
+template <class T>
+inline void run_tile(void (*tile)(const T*, const T*, int, int, double*),
+                     const T* norm, int stride, int i0, int j0,
+                     double* acc, int ny, float* result)
+{
+    const bool diag = (i0 == j0);
+    tile(norm + (size_t)i0 * stride, norm + (size_t)j0 * stride, stride, diag, acc);
+
+    const int iend = std::min(i0 + TILE, ny);
+    for (int i = i0; i < iend; ++i) {
+        const int jend = diag ? i + 1 : std::min(j0 + TILE, ny);
+        for (int j = j0; j < jend; ++j)
+            result[i + (size_t)j * ny] = clamp_r(acc[(i - i0) * TILE + (j - j0)]);
+    }
+}
+
+#endif // FUNCTIONS_INTERNAL_H
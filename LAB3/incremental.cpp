@@ -0,0 +1,189 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  INCREMENTAL ENGINE
+//
+//  Pearson r only needs, per row, the mean and, per pair, the co-moment
+//  C_ij = Σ (x_i - m_i)(x_j - m_j):  r_ij = C_ij / √(C_ii · C_jj).
+//
+//  New columns: a batch B of k columns has its own means b_i and
+//  co-moments D_ij.  Merging with the n columns seen so far (Chan, Golub
+//  and LeVeque's pairwise update, which for k = 1 is Welford's):
+//
+//    δ_i   = b_i - m_i
+//    C_ij += D_ij + δ_i δ_j · n k / (n + k)
+//    m_i  += δ_i · k / (n + k)
+//
+//  Only centred quantities are ever summed, so nothing like Σ x² - n m²
+//  cancels catastrophically, however many batches are merged.  D is a
+//  k-deep SYRK over the triangle: O(ny² · k).
+//
+//  New row: its co-moments with the existing rows are ny dot-products of
+//  centred length-nx vectors, O(ny · nx); they extend the packed triangle
+//  at its end.
+// ─────────────────────────────────────────────────────────────────────────────
+
+void incremental_init(IncrementalCorrelation& s, int ny, int nx, const float* data)
+{
+    s.ny = ny;
+    s.nx = nx;
+    s.rows.resize(ny);
+    s.mean.assign(ny, 0.0);
+    s.comoment.assign(packed_index(ny, 0), 0.0);
+
+    // The bulk start reuses Task 4: its tiles accumulate r_ij in double from
+    // the normalised rows, and C_ij = r_ij · √C_ii · √C_jj.
+    const int stride = padded_stride<double>(nx);
+    const int nt     = (ny + TILE - 1) / TILE;
+    AlignedMatrix<double> norm;
+    std::vector<double>   sd(ny);
+    normalise_rows(ny, nx, data, norm, nt * TILE);
+
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < ny; ++y) {
+        const float* x = data + (size_t)y * nx;
+        s.rows[y].assign(x, x + nx);
+        double sum = 0.0;
+        for (int c = 0; c < nx; ++c)
+            sum += x[c];
+        const double m = sum / nx;
+        double sq = 0.0;
+        for (int c = 0; c < nx; ++c)
+            sq += (x[c] - m) * (x[c] - m);
+        s.mean[y] = m;
+        sd[y]     = std::sqrt(sq);
+    }
+
+    std::vector<int> tiles;   // (I, J) tile pairs, J <= I
+    for (int bi = 0; bi < nt; ++bi)
+        for (int bj = 0; bj <= bi; ++bj) {
+            tiles.push_back(bi);
+            tiles.push_back(bj);
+        }
+    const int   ntiles = (int)tiles.size() / 2;
+    tile_f64_fn tile   = select_kernels().tile_f64;
+
+#pragma omp parallel
+    {
+        std::vector<double> acc(TILE * TILE);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < ntiles; ++t) {
+            const int i0 = tiles[2 * t] * TILE;
+            const int j0 = tiles[2 * t + 1] * TILE;
+            const bool diag = (i0 == j0);
+            tile(norm.row(i0), norm.row(j0), stride, diag, acc.data());
+
+            const int iend = std::min(i0 + TILE, ny);
+            for (int i = i0; i < iend; ++i) {
+                const int jend = diag ? i + 1 : std::min(j0 + TILE, ny);
+                for (int j = j0; j < jend; ++j)
+                    s.comoment[packed_index(i, j)] = acc[(i - i0) * TILE + (j - j0)] * sd[i] * sd[j];
+            }
+        }
+    }
+}
+
+void incremental_append_columns(IncrementalCorrelation& s, int k, const float* cols)
+{
+    if (k <= 0)
+        return;
+    const int    ny = s.ny;
+    const double n  = s.nx;
+
+    // Centre the batch on its own means: dev(y, c) = x - b_y, rows padded
+    // with zeros to the aligned stride the dot kernel expects.
+    const int kp = padded_stride<double>(k);
+    AlignedMatrix<double> dev(ny, k, kp);
+    std::vector<double>   delta(ny);
+    dev.fill(0.0);
+
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < ny; ++y) {
+        const float* x = cols + (size_t)y * k;
+        double sum = 0.0;
+        for (int c = 0; c < k; ++c)
+            sum += x[c];
+        const double b = sum / k;
+        for (int c = 0; c < k; ++c)
+            dev(y, c) = x[c] - b;
+        delta[y] = b - s.mean[y];
+        s.rows[y].insert(s.rows[y].end(), x, x + k);
+    }
+
+    const double f = n * k / (n + k);
+    double (*dot_simd)(const double*, const double*, int) = select_kernels().dot_f64;
+
+    for_each_pair_tile(ny, Schedule::Triangle, [&](const TriTile& t) {
+        for (int i = t.i0; i < t.i1; ++i) {
+            const double* di = dev.row(i);
+            const int jend = std::min(t.j1, i + 1);
+            for (int j = t.j0; j < jend; ++j)
+                s.comoment[packed_index(i, j)] += dot_simd(di, dev.row(j), kp)
+                                                + f * delta[i] * delta[j];
+        }
+    }, nullptr);
+
+    for (int y = 0; y < ny; ++y)
+        s.mean[y] += delta[y] * k / (n + k);
+    s.nx += k;
+}
+
+void incremental_append_row(IncrementalCorrelation& s, const float* row)
+{
+    const int ny = s.ny;
+    const int nx = s.nx;
+
+    double sum = 0.0;
+    for (int x = 0; x < nx; ++x)
+        sum += row[x];
+    const double m = (nx > 0) ? sum / nx : 0.0;
+
+    std::vector<double> dev(nx);
+    for (int x = 0; x < nx; ++x)
+        dev[x] = row[x] - m;
+
+    // Row ny of the packed triangle sits right after the existing ones.
+    s.comoment.resize(packed_index(ny + 1, 0));
+    double* out = &s.comoment[packed_index(ny, 0)];
+
+#pragma omp parallel for schedule(static)
+    for (int j = 0; j < ny; ++j) {
+        const float* xj = s.rows[j].data();
+        const double mj = s.mean[j];
+        double c = 0.0;
+        for (int x = 0; x < nx; ++x)
+            c += dev[x] * (xj[x] - mj);
+        out[j] = c;
+    }
+    double sq = 0.0;
+    for (int x = 0; x < nx; ++x)
+        sq += dev[x] * dev[x];
+    out[ny] = sq;
+
+    s.rows.push_back(std::vector<float>(row, row + nx));
+    s.mean.push_back(m);
+    s.ny = ny + 1;
+}
+
+void incremental_result(const IncrementalCorrelation& s, float* result)
+{
+    const int ny = s.ny;
+
+    // 1/√C_ii, 0 for zero-variance rows (as normalise_rows does).
+    std::vector<double> inv(ny);
+    for (int y = 0; y < ny; ++y) {
+        const double c = s.comoment[packed_index(y, y)];
+        inv[y] = (c > 0.0) ? 1.0 / std::sqrt(c) : 0.0;
+    }
+
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int i = 0; i < ny; ++i)
+        for (int j = 0; j <= i; ++j)
+            result[i + (size_t)j * ny] = clamp_r(s.comoment[packed_index(i, j)] * inv[i] * inv[j]);
+}
@@ -0,0 +1,73 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Internal interface between functions.cpp and the per-ISA kernel objects.
+//
+//  kernels_impl.h is compiled once per instruction-set level (kernels_sse2.cpp,
+//  kernels_avx2.cpp, kernels_avx512.cpp, each with its own -m flags), and
+//  every build exports one KernelTable.  functions.cpp is compiled for the
+//  baseline ISA and only ever reaches the wide code through the table that
+//  select_kernels() picked at startup, so one binary runs on every node.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// Rows per cache block in the Task 4 tile loop (multiple of every MR / NR).
+const int TILE = 48;
+
+// Row strides handed to the tile kernels are padded to a multiple of this
+// many bytes (one AVX-512 vector), whatever ISA is selected.
+const int ROW_ALIGN_BYTES = 64;
+
+/**
+ * Accumulate one TILE × TILE block of row-pair dot-products:
+ *   acc[r * TILE + q] = dot(a row r, b row q)      0 <= r, q < TILE
+ * where rows are `stride` elements apart and zero-padded to a multiple of
+ * ROW_ALIGN_BYTES.  `a` and `b` may point into different buffers (the
+ * out-of-core driver pairs two row panels).  When `diag` is set, a == b and
+ * micro-tiles lying entirely above the diagonal (q > r) are skipped.
+ */
+typedef void (*tile_f64_fn)(const double* a, const double* b, int stride, int diag, double* acc);
+typedef void (*tile_f32_fn)(const float*  a, const float*  b, int stride, int diag, double* acc);
+
+struct KernelTable {
+    const char* name;                       // "sse2", "avx2", "avx512"
+    // Dot-product of two padded rows: a and b ROW_ALIGN_BYTES-aligned, n a
+    // multiple of ROW_ALIGN_BYTES / sizeof(double) (padded_stride).
+    double (*dot_f64)(const double* a, const double* b, int n);
+
+    // Missing values: over n <= 64 elements (whole vectors, aligned) with
+    // validity bits ma / mb, s += {Σa, Σb, Σa², Σb²}, each summed only
+    // where the other row's bit is clear.
+    void (*masked_f64)(const double* a, const double* b,
+                       unsigned long long ma, unsigned long long mb, int n, double* s);
+
+    // Fused row normalisation: nx floats → out[0, stride) with zero mean,
+    // unit length and zeroed padding (statistics always in double).
+    void (*normalise_f64)(int nx, const float* row, double* out, int stride);
+    void (*normalise_f32)(int nx, const float* row, float*  out, int stride);
+
+    tile_f64_fn tile_f64;                   // Precision::Double
+    tile_f32_fn tile_f32_f64;               // Precision::Mixed
+    tile_f32_fn tile_f32;                   // Precision::Float
+
+    // Packed SYRK micro-kernels (syrk.cpp): an mr × nr block
+    //   c[n * mr + m] = Σ_k a[k * mr + m] · b[k * nr + n]
+    // from k-major micro-panels a (mr wide) and b (nr wide).
+    int syrk_mr_f64, syrk_nr_f64;
+    void (*syrk_f64)(int kc, const double* a, const double* b, double* c);
+    int syrk_mr_f32, syrk_nr_f32;
+    void (*syrk_f32)(int kc, const float* a, const float* b, float* c);
+};
+
+const KernelTable& kernels_sse2();
+const KernelTable& kernels_avx2();
+const KernelTable& kernels_avx512();
+
+/**
+ * Best table for the running CPU (cpuid via __builtin_cpu_supports), chosen
+ * once on first use.  CORRELATE_ISA=sse2|avx2|avx512 forces a level for A/B
+ * testing; a forced level the CPU cannot run is lowered with a warning.
+ */
+const KernelTable& select_kernels();
+
+#endif // KERNELS_H
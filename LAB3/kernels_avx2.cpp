@@ -0,0 +1,8 @@
+// Compiled with $(ISA_AVX2) = -mavx2 -mfma (see Makefile).
+#include "kernels_impl.h"
+
+const KernelTable& kernels_avx2()
+{
+    static const KernelTable k = make_table("avx2");
+    return k;
+}
@@ -0,0 +1,8 @@
+// Compiled with $(ISA_AVX512) = -mavx512f -mavx2 -mfma (see Makefile).
+#include "kernels_impl.h"
+
+const KernelTable& kernels_avx512()
+{
+    static const KernelTable k = make_table("avx512");
+    return k;
+}
@@ -0,0 +1,436 @@
+// ─────────────────────────────────────────────────────────────────────────────
+//  kernels_impl.h  –  SIMD kernels, included by exactly one kernels_<isa>.cpp
+//
+//  The including file is compiled with that ISA's -m flags and then defines
+//  its KernelTable.  Everything here lives in an anonymous namespace: with
+//  external linkage the linker could keep the AVX-512 copy of an inline
+//  function for the whole program and SIGILL on older CPUs.  For the same
+//  reason this file uses no standard-library templates.
+//
+//  load() is an aligned load: every buffer comes from aligned_malloc and
+//  every row stride and panel offset is a multiple of ROW_ALIGN_BYTES.
+//  Only the raw input rows read by normalise() use loadu().
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "kernels.h"
+#include <immintrin.h>   // AVX / SSE intrinsics
+
+#ifndef __SSE2__
+#error "kernels_impl.h needs at least SSE2"
+#endif
+
+namespace {
+
+#if defined(__AVX512F__)
+
+// Spill-and-add reductions: GCC 12's 512→256 extract intrinsics trip a
+// bogus -Wuninitialized, and these run only once per micro-tile per panel.
+inline double hsum(__m512d v) {
+    alignas(64) double t[8];
+    _mm512_store_pd(t, v);
+    return ((t[0] + t[4]) + (t[1] + t[5])) + ((t[2] + t[6]) + (t[3] + t[7]));
+}
+
+inline double hsum(__m512 v) {
+    alignas(64) float t[16];
+    _mm512_store_ps(t, v);
+    double s = 0.0;
+    for (int l = 0; l < 16; ++l)
+        s += t[l];
+    return s;
+}
+
+struct simd_f64 {
+    typedef double  elem;
+    typedef __m512d reg;
+    enum { width = 8, MR = 4, NR = 4 };   // 16 accumulators of 32 zmm
+    static inline reg zero()                          { return _mm512_setzero_pd(); }
+    static inline reg load(const elem* p)             { return _mm512_load_pd(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm512_fmadd_pd(a, b, c); }
+    static inline reg add(reg a, reg b)               { return _mm512_add_pd(a, b); }
+    static inline reg set1(elem x)                    { return _mm512_set1_pd(x); }
+    static inline void store(elem* p, reg v)          { _mm512_storeu_pd(p, v); }
+    // Lanes whose bit (lane l = bit l) is clear become 0: one k-register op.
+    static inline reg maskz(unsigned bits, reg v)     { return _mm512_maskz_mov_pd((__mmask8)bits, v); }
+    enum { SYRK_MV = 3, SYRK_NR = 8 };    // SYRK tile 24 × 8: 24 accumulators
+};
+
+struct simd_f32_f64 {
+    typedef float   elem;
+    typedef __m512d reg;
+    enum { width = 8, MR = 4, NR = 4 };
+    static inline reg zero()                          { return _mm512_setzero_pd(); }
+    static inline reg load(const elem* p) {
+        // maskz form: the plain _mm512_cvtps_pd trips the same GCC 12 warning
+        return _mm512_maskz_cvtps_pd((__mmask8)0xFF, _mm256_load_ps(p));
+    }
+    static inline reg loadu(const elem* p) {
+        return _mm512_maskz_cvtps_pd((__mmask8)0xFF, _mm256_loadu_ps(p));
+    }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm512_fmadd_pd(a, b, c); }
+    static inline reg sub(reg a, reg b)               { return _mm512_sub_pd(a, b); }
+    static inline reg mul(reg a, reg b)               { return _mm512_mul_pd(a, b); }
+    static inline reg set1(double x)                  { return _mm512_set1_pd(x); }
+    static inline void store(double* p, reg v)        { _mm512_storeu_pd(p, v); }
+    static inline void store(float* p, reg v) {
+        _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps((__mmask8)0xFF, v));
+    }
+};
+
+struct simd_f32 {
+    typedef float  elem;
+    typedef __m512 reg;
+    enum { width = 16, MR = 4, NR = 4 };
+    static inline reg zero()                          { return _mm512_setzero_ps(); }
+    static inline reg load(const elem* p)             { return _mm512_load_ps(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm512_fmadd_ps(a, b, c); }
+    static inline reg set1(elem x)                    { return _mm512_set1_ps(x); }
+    static inline void store(elem* p, reg v)          { _mm512_storeu_ps(p, v); }
+    enum { SYRK_MV = 3, SYRK_NR = 8 };    // SYRK tile 48 × 8
+};
+
+#elif defined(__AVX2__)
+
+// Horizontal sum of a 256-bit AVX double register (4 × double)
+inline double hsum(__m256d v) {
+    __m128d lo = _mm256_castpd256_pd128(v);
+    __m128d hi = _mm256_extractf128_pd(v, 1);
+    __m128d s  = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_hadd_pd(s, s));
+}
+
+// Horizontal sum of a 256-bit AVX float register (8 × float)
+inline double hsum(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+struct simd_f64 {
+    typedef double  elem;
+    typedef __m256d reg;
+    enum { width = 4, MR = 3, NR = 3 };   // 9 accumulators of 16 ymm
+    static inline reg zero()                          { return _mm256_setzero_pd(); }
+    static inline reg load(const elem* p)             { return _mm256_load_pd(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm256_fmadd_pd(a, b, c); }
+    static inline reg add(reg a, reg b)               { return _mm256_add_pd(a, b); }
+    static inline reg set1(elem x)                    { return _mm256_set1_pd(x); }
+    static inline void store(elem* p, reg v)          { _mm256_storeu_pd(p, v); }
+    // Broadcast the bits, test lane l against bit l, AND with the result.
+    static inline reg maskz(unsigned bits, reg v) {
+        const __m256i sel = _mm256_set_epi64x(8, 4, 2, 1);
+        const __m256i on  = _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), sel), sel);
+        return _mm256_and_pd(v, _mm256_castsi256_pd(on));
+    }
+    enum { SYRK_MV = 2, SYRK_NR = 6 };    // SYRK tile 8 × 6: 12 accumulators
+};
+
+struct simd_f32_f64 {
+    typedef float   elem;
+    typedef __m256d reg;
+    enum { width = 4, MR = 3, NR = 3 };
+    static inline reg zero()                          { return _mm256_setzero_pd(); }
+    static inline reg load(const elem* p)             { return _mm256_cvtps_pd(_mm_load_ps(p)); }
+    static inline reg loadu(const elem* p)            { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm256_fmadd_pd(a, b, c); }
+    static inline reg sub(reg a, reg b)               { return _mm256_sub_pd(a, b); }
+    static inline reg mul(reg a, reg b)               { return _mm256_mul_pd(a, b); }
+    static inline reg set1(double x)                  { return _mm256_set1_pd(x); }
+    static inline void store(double* p, reg v)        { _mm256_storeu_pd(p, v); }
+    static inline void store(float* p, reg v)         { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+};
+
+struct simd_f32 {
+    typedef float  elem;
+    typedef __m256 reg;
+    enum { width = 8, MR = 3, NR = 3 };
+    static inline reg zero()                          { return _mm256_setzero_ps(); }
+    static inline reg load(const elem* p)             { return _mm256_load_ps(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm256_fmadd_ps(a, b, c); }
+    static inline reg set1(elem x)                    { return _mm256_set1_ps(x); }
+    static inline void store(elem* p, reg v)          { _mm256_storeu_ps(p, v); }
+    enum { SYRK_MV = 2, SYRK_NR = 6 };    // SYRK tile 16 × 6
+};
+
+#else   // SSE2: x86-64 baseline, no FMA
+
+// Horizontal sum of a 128-bit SSE double register (2 × double)
+inline double hsum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+// Horizontal sum of a 128-bit SSE float register (4 × float)
+inline double hsum(__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+struct simd_f64 {
+    typedef double  elem;
+    typedef __m128d reg;
+    enum { width = 2, MR = 3, NR = 3 };   // 9 accumulators of 16 xmm
+    static inline reg zero()                          { return _mm_setzero_pd(); }
+    static inline reg load(const elem* p)             { return _mm_load_pd(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static inline reg add(reg a, reg b)               { return _mm_add_pd(a, b); }
+    static inline reg set1(elem x)                    { return _mm_set1_pd(x); }
+    static inline void store(elem* p, reg v)          { _mm_storeu_pd(p, v); }
+    // No 64-bit compare in SSE2: compare both 32-bit halves of each lane.
+    static inline reg maskz(unsigned bits, reg v) {
+        const __m128i sel = _mm_set_epi32(2, 2, 1, 1);
+        const __m128i on  = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)bits), sel), sel);
+        return _mm_and_pd(v, _mm_castsi128_pd(on));
+    }
+    enum { SYRK_MV = 2, SYRK_NR = 6 };    // SYRK tile 4 × 6: 12 accumulators
+};
+
+struct simd_f32_f64 {
+    typedef float   elem;
+    typedef __m128d reg;
+    enum { width = 2, MR = 3, NR = 3 };
+    static inline reg zero()                          { return _mm_setzero_pd(); }
+    static inline reg load(const elem* p) {   // 8 bytes: no alignment needed
+        return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd((const double*)p)));
+    }
+    static inline reg loadu(const elem* p)            { return load(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static inline reg sub(reg a, reg b)               { return _mm_sub_pd(a, b); }
+    static inline reg mul(reg a, reg b)               { return _mm_mul_pd(a, b); }
+    static inline reg set1(double x)                  { return _mm_set1_pd(x); }
+    static inline void store(double* p, reg v)        { _mm_storeu_pd(p, v); }
+    static inline void store(float* p, reg v)         { _mm_storel_pi((__m64*)p, _mm_cvtpd_ps(v)); }
+};
+
+struct simd_f32 {
+    typedef float  elem;
+    typedef __m128 reg;
+    enum { width = 4, MR = 3, NR = 3 };
+    static inline reg zero()                          { return _mm_setzero_ps(); }
+    static inline reg load(const elem* p)             { return _mm_load_ps(p); }
+    static inline reg fmadd(reg a, reg b, reg c)      { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static inline reg set1(elem x)                    { return _mm_set1_ps(x); }
+    static inline void store(elem* p, reg v)          { _mm_storeu_ps(p, v); }
+    enum { SYRK_MV = 2, SYRK_NR = 6 };    // SYRK tile 8 × 6
+};
+
+#endif
+
+const int KC_BYTES = 2048;   // bytes per x-panel: 2·48·2 KB = 192 KB in L2
+
+/**
+ * c[r*ldc + q] += dot(a row r, b row q) over the x-range [k0, k1) for an
+ * MR × NR micro-tile.  Rows are `stride` elements apart and the range is a
+ * whole number of SIMD vectors (the rows are zero-padded to guarantee it).
+ */
+template <class V, int MR, int NR>
+inline void micro_tile(const typename V::elem* a,
+                       const typename V::elem* b, long stride,
+                       int k0, int k1, double* c, int ldc)
+{
+    typename V::reg acc[MR][NR];
+    for (int r = 0; r < MR; ++r)
+        for (int q = 0; q < NR; ++q)
+            acc[r][q] = V::zero();
+
+    for (int k = k0; k < k1; k += V::width) {
+        typename V::reg va[MR];
+        for (int r = 0; r < MR; ++r)
+            va[r] = V::load(a + r * stride + k);
+        for (int q = 0; q < NR; ++q) {
+            typename V::reg vb = V::load(b + q * stride + k);
+            for (int r = 0; r < MR; ++r)
+                acc[r][q] = V::fmadd(va[r], vb, acc[r][q]);
+        }
+    }
+
+    for (int r = 0; r < MR; ++r)
+        for (int q = 0; q < NR; ++q)
+            c[r * ldc + q] += hsum(acc[r][q]);
+}
+
+/**
+ * One TILE × TILE block (see tile_f64_fn).  x is walked in KC_BYTES panels
+ * so that the 2 × TILE row slices stay cache-resident while every
+ * micro-tile of the block re-reads them.
+ */
+template <class V>
+void tile(const typename V::elem* a, const typename V::elem* b,
+          int stride, int diag, double* acc)
+{
+    const int  MR = V::MR, NR = V::NR;
+    const int  KC = KC_BYTES / (int)sizeof(typename V::elem);
+    const long sz = stride;
+
+    for (int e = 0; e < TILE * TILE; ++e)
+        acc[e] = 0.0;
+
+    for (int k0 = 0; k0 < stride; k0 += KC) {
+        const int k1 = (k0 + KC < stride) ? k0 + KC : stride;
+        for (int ii = 0; ii < TILE; ii += MR) {
+            for (int jj = 0; jj < TILE; jj += NR) {
+                if (diag && jj > ii + MR - 1)
+                    break;   // micro-tile lies entirely above diagonal
+                micro_tile<V, MR, NR>(a + ii * sz, b + jj * sz, sz,
+                                      k0, k1, &acc[ii * TILE + jj], TILE);
+            }
+        }
+    }
+}
+
+/**
+ * Packed SYRK / GEMM micro-kernel (Impl::Syrk), BLIS style:
+ *   c[n * MR + m] = Σ_k a[k * MR + m] · b[k * NR + n]
+ * with MR = SYRK_MV SIMD vectors of rows and NR broadcast columns.  `a` and
+ * `b` are micro-panels packed k-major by syrk.cpp, so every load is a
+ * contiguous vector and the MR × NR accumulators never leave registers.
+ */
+template <class V>
+void syrk_micro(int kc, const typename V::elem* a, const typename V::elem* b,
+                typename V::elem* c)
+{
+    const int MV = V::SYRK_MV, NR = V::SYRK_NR, W = V::width, MR = MV * W;
+
+    typename V::reg acc[NR][MV];
+    for (int n = 0; n < NR; ++n)
+        for (int v = 0; v < MV; ++v)
+            acc[n][v] = V::zero();
+
+    for (int k = 0; k < kc; ++k) {
+        typename V::reg va[MV];
+        for (int v = 0; v < MV; ++v)
+            va[v] = V::load(a + k * MR + v * W);
+        for (int n = 0; n < NR; ++n) {
+            typename V::reg vb = V::set1(b[k * NR + n]);
+            for (int v = 0; v < MV; ++v)
+                acc[n][v] = V::fmadd(va[v], vb, acc[n][v]);
+        }
+    }
+
+    for (int n = 0; n < NR; ++n)
+        for (int v = 0; v < MV; ++v)
+            V::store(c + n * MR + v * W, acc[n][v]);
+}
+
+/**
+ * Normalise one row of nx floats into out[0, stride): zero mean and unit
+ * length, computed in double whatever O is; out[nx, stride) is zeroed.
+ *
+ * Pass 1 reads the row once, running Welford's update independently in
+ * every lane (lane l sees x[l], x[l + W], ...), then merges the lanes with
+ * Chan's formula — pairwise, so a constant row gives exactly zero — and
+ * folds in the tail.  Pass 2 converts, centres, scales and stores in one
+ * sweep while the row is still in L1.
+ */
+template <class O>
+void normalise(int nx, const float* row, O* out, int stride)
+{
+    typedef simd_f32_f64 V;
+    const int W = V::width;
+
+    V::reg mean = V::zero(), m2 = V::zero();
+    int x = 0, n = 0;
+    for (; x <= nx - W; x += W) {
+        ++n;
+        V::reg v = V::loadu(row + x);
+        V::reg d = V::sub(v, mean);
+        mean = V::fmadd(d, V::set1(1.0 / n), mean);
+        m2   = V::fmadd(d, V::sub(v, mean), m2);
+    }
+
+    double mu = 0.0, q = 0.0;
+    int count = 0;
+    if (n > 0) {
+        alignas(64) double lm[W], lq[W];
+        V::store(lm, mean);
+        V::store(lq, m2);
+        double t[W];
+        for (int l = 0; l < W; ++l)
+            t[l] = lm[l];
+        for (int h = W / 2; h > 0; h /= 2)      // pairwise lane sum
+            for (int l = 0; l < h; ++l)
+                t[l] += t[l + h];
+        mu = t[0] / W;
+        for (int l = 0; l < W; ++l)
+            q += lq[l] + n * (lm[l] - mu) * (lm[l] - mu);
+        count = n * W;
+    }
+    for (; x < nx; ++x) {
+        ++count;
+        const double d = row[x] - mu;
+        mu += d / count;
+        q  += d * (row[x] - mu);
+    }
+
+    const double inv = (q > 0.0) ? 1.0 / __builtin_sqrt(q) : 0.0;
+    const V::reg vm = V::set1(mu), vi = V::set1(inv);
+    for (x = 0; x <= nx - W; x += W)
+        V::store(out + x, V::mul(V::sub(V::loadu(row + x), vm), vi));
+    for (; x < nx; ++x)
+        out[x] = (O)((row[x] - mu) * inv);
+    for (; x < stride; ++x)
+        out[x] = O(0);
+}
+
+// Single dot-product, for the row-pair kernel (Task 3).
+double dot(const double* a, const double* b, int n)
+{
+    typedef simd_f64 V;
+    V::reg acc = V::zero();
+    for (int x = 0; x < n; x += V::width)      // n is a whole number of vectors
+        acc = V::fmadd(V::load(a + x), V::load(b + x), acc);
+    return hsum(acc);
+}
+
+/**
+ * Missing-value corrections (nan.cpp) over one block of n <= 64 elements
+ * with validity words ma / mb (bit k: a[k] / b[k] present):
+ *   s += { Σ a, Σ b, Σ a², Σ b² }  each taken where the other row is missing
+ * The masks are applied in-register; n is a whole number of vectors.
+ */
+void masked_sums(const double* a, const double* b,
+                 unsigned long long ma, unsigned long long mb, int n, double* s)
+{
+    typedef simd_f64 V;
+    const int      W    = V::width;
+    const unsigned lane = (1u << W) - 1;
+
+    V::reg sa = V::zero(), sb = V::zero(), saa = V::zero(), sbb = V::zero();
+    for (int x = 0; x < n; x += W) {
+        const unsigned gap_a = ~(unsigned)(ma >> x) & lane;
+        const unsigned gap_b = ~(unsigned)(mb >> x) & lane;
+        const V::reg va = V::load(a + x), vb = V::load(b + x);
+        const V::reg xa = V::maskz(gap_b, va), xb = V::maskz(gap_a, vb);
+        sa  = V::add(sa, xa);
+        sb  = V::add(sb, xb);
+        saa = V::fmadd(xa, va, saa);
+        sbb = V::fmadd(xb, vb, sbb);
+    }
+    s[0] += hsum(sa);
+    s[1] += hsum(sb);
+    s[2] += hsum(saa);
+    s[3] += hsum(sbb);
+}
+
+KernelTable make_table(const char* name)
+{
+    KernelTable k;
+    k.name          = name;
+    k.dot_f64       = dot;
+    k.masked_f64    = masked_sums;
+    k.normalise_f64 = normalise<double>;
+    k.normalise_f32 = normalise<float>;
+    k.tile_f64      = tile<simd_f64>;
+    k.tile_f32_f64  = tile<simd_f32_f64>;
+    k.tile_f32      = tile<simd_f32>;
+    k.syrk_mr_f64   = simd_f64::SYRK_MV * simd_f64::width;
+    k.syrk_nr_f64   = simd_f64::SYRK_NR;
+    k.syrk_f64      = syrk_micro<simd_f64>;
+    k.syrk_mr_f32   = simd_f32::SYRK_MV * simd_f32::width;
+    k.syrk_nr_f32   = simd_f32::SYRK_NR;
+    k.syrk_f32      = syrk_micro<simd_f32>;
+    return k;
+}
+
+} // namespace
@@ -0,0 +1,8 @@
+// Compiled with $(ISA_SSE2) = -msse2 (see Makefile).
+#include "kernels_impl.h"
+
+const KernelTable& kernels_sse2()
+{
+    static const KernelTable k = make_table("sse2");
+    return k;
+}
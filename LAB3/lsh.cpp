@@ -0,0 +1,147 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  APPROXIMATE SEARCH — SimHash / LSH
+//
+//  Normalised rows are unit vectors, so r_ij is the cosine of their angle.
+//  For a random Gaussian direction g, sign(g · x_i) = sign(g · x_j) with
+//  probability 1 - θ_ij / π (Charikar's SimHash), so short sign sketches
+//  of many such projections preserve angles.  The sketches are cut into
+//  `tables` bands of `bits` bits; rows whose band is equal fall in the
+//  same bucket of that table, and only pairs sharing at least one bucket
+//  are ever looked at:
+//
+//    sketch    ny × tables·bits projections             O(ny · nx · bits · tables)
+//    bucket    sort (band, row) per table, pair up the rows of each bucket
+//    verify    exact r of each pair in the first table it collides in
+//
+//  A pair is verified on the spot, and only in the first table whose band
+//  it shares (an O(t) compare of the earlier bands), so no candidate list
+//  is ever stored and the working set is the sketches, one bucket sort
+//  per thread and the pairs that pass.  A row and its negation have
+//  complementary sketches, so a band is stored in canonical form (top bit
+//  clear, else complemented): pairs with r ≈ -1 share buckets as well,
+//  matching correlate_threshold's |r| test.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// The band with its top bit cleared by complementing if needed.
+static uint32_t canonical(uint32_t key, int bits)
+{
+    const uint32_t mask = (bits == 32) ? 0xffffffffu : ((1u << bits) - 1);
+    return (key >> (bits - 1) & 1) ? ~key & mask : key;
+}
+
+int lsh_bits(int ny)
+{
+    int bits = 1;
+    while (bits < 32 && ny > (16ll << (bits - 1)))
+        ++bits;
+    return bits;
+}
+
+size_t correlate_approx(int ny, int nx, const float* data, float threshold,
+                        SparseCorrelation& out, const LshOptions& opt)
+{
+    out.row_ptr.assign(ny + 1, 0);
+    out.col.clear();
+    out.val.clear();
+    if (ny < 2)
+        return 0;
+
+    const int bits   = std::max(1, std::min(32, opt.bits > 0 ? opt.bits : lsh_bits(ny)));
+    const int tables = std::max(1, opt.tables);
+    const int nproj  = bits * tables;
+    const int stride = padded_stride<double>(nx);
+    double (*dot_simd)(const double*, const double*, int) = select_kernels().dot_f64;
+
+    AlignedMatrix<double> norm;
+    normalise_rows(ny, nx, data, norm, ny);
+
+    // Gaussian directions, padded like the rows so the dot kernel applies.
+    AlignedMatrix<double> dir(nproj, nx, stride);
+    dir.fill(0.0);
+    std::mt19937 gen(opt.seed);
+    std::normal_distribution<double> normal;
+    for (int b = 0; b < nproj; ++b)
+        for (int x = 0; x < nx; ++x)
+            dir(b, x) = normal(gen);
+
+    // sketch[y * tables + t]: band t of row y.
+    std::vector<uint32_t> sketch((size_t)ny * tables);
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < ny; ++y) {
+        const double* row = norm.row(y);
+        for (int t = 0; t < tables; ++t) {
+            uint32_t key = 0;
+            for (int b = 0; b < bits; ++b)
+                key = key << 1 | (dot_simd(row, dir.row(t * bits + b), stride) >= 0.0);
+            sketch[(size_t)y * tables + t] = canonical(key, bits);
+        }
+    }
+
+    // Pairs (i, j), j < i, that pass, keyed i << 32 | j so that sorting
+    // them yields the CSR order.  Each pair is verified once, in the first
+    // table it collides in, so the keys are distinct.
+    typedef std::pair<uint64_t, float> Hit;
+    std::vector<std::vector<Hit> > local(omp_get_max_threads());
+    long long ncand = 0;
+#pragma omp parallel reduction(+:ncand)
+    {
+        std::vector<Hit>& mine = local[omp_get_thread_num()];
+        std::vector<std::pair<uint32_t, int> > bucket(ny);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < tables; ++t) {
+            for (int y = 0; y < ny; ++y)
+                bucket[y] = std::make_pair(sketch[(size_t)y * tables + t], y);
+            std::sort(bucket.begin(), bucket.end());
+
+            for (int b0 = 0, b1; b0 < ny; b0 = b1) {
+                for (b1 = b0 + 1; b1 < ny && bucket[b1].first == bucket[b0].first; ++b1) {}
+                // Rows within a bucket are sorted, so i > j below.
+                for (int a = b0 + 1; a < b1; ++a)
+                    for (int c = b0; c < a; ++c) {
+                        const int i = bucket[a].second;
+                        const int j = bucket[c].second;
+                        const uint32_t* si = &sketch[(size_t)i * tables];
+                        const uint32_t* sj = &sketch[(size_t)j * tables];
+                        int u = 0;
+                        while (u < t && si[u] != sj[u])
+                            ++u;
+                        if (u < t)
+                            continue;   // verified in table u already
+                        ++ncand;
+                        const float r = clamp_r(dot_simd(norm.row(i), norm.row(j), stride));
+                        if (std::fabs(r) > threshold)
+                            mine.push_back(Hit((uint64_t)i << 32 | (uint32_t)j, r));
+                    }
+            }
+        }
+    }
+
+    std::vector<Hit> hits;
+    for (size_t th = 0; th < local.size(); ++th) {
+        hits.insert(hits.end(), local[th].begin(), local[th].end());
+        std::vector<Hit>().swap(local[th]);
+    }
+    std::sort(hits.begin(), hits.end());
+
+    out.col.reserve(hits.size());
+    out.val.reserve(hits.size());
+    for (size_t h = 0; h < hits.size(); ++h) {
+        out.row_ptr[(hits[h].first >> 32) + 1] += 1;
+        out.col.push_back((int)(hits[h].first & 0xffffffffu));
+        out.val.push_back(hits[h].second);
+    }
+    for (int i = 0; i < ny; ++i)
+        out.row_ptr[i + 1] += out.row_ptr[i];
+    return (size_t)ncand;
+}
\ No newline at end of file
@@ -1,40 +1,350 @@
 #include <iostream>
+#include <iomanip>
 #include <vector>
+#include <string>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
 #include <chrono>
+#include <algorithm>
+#include <fstream>
 #include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "aligned.h"
 #include "functions.h"
+#include "../common/transpose.h"
 
 // ─────────────────────────────────────────────────────────────────────────────
 //  Usage:
-//    ./correlate <ny> <nx> [num_threads]
+//    ./correlate <ny> <nx> [num_threads] [--impl NAME] [--precision P]
 //
 //  ny            = number of rows (vectors)
 //  nx            = number of columns (elements per vector)
 //  num_threads   = OpenMP thread count (optional, default = max available)
+//  --impl        = auto|sequential|openmp|vectorised|blocked|syrk|all
+//                  (default auto); "all" times every implementation
+//  --precision   = double|mixed|float|all, for the blocked and syrk kernels
+//                  (default double); "all" reports each mode's time and error
+//  --nan F       = turn a fraction F of the input cells into NaN and run the
+//                  pairwise-complete (missing-value) mode, timed against
+//                  the dense correlate() and the same mode without NaNs
+//  --method M    = pearson|spearman|kendall (default pearson).  Spearman
+//                  ranks the rows and runs the first --impl / --precision
+//                  on the ranks; Kendall's tau-b has its own kernel
+//  --columns     = correlate the nx columns instead (nx x nx result) with
+//                  correlate_columns() and the first --impl / --precision;
+//                  its transpose is also timed alone
+//  --ooc IN OUT  = out-of-core run: mmap IN (raw float32, ny x nx) and stream
+//                  the result to OUT (dense ny x ny float32).  A missing IN
+//                  is first synthesised from the same LCG as fill_matrix.
+//  --input FILE  = mmap FILE (raw float32 ny x nx, or a float32 .npy whose
+//                  header gives the shape: pass ny nx as 0 0) and run the
+//                  first --impl / --precision on it in place; the mapping
+//                  time is reported apart from the compute time
+//  --save FILE   = map FILE (raw or .npy, by extension) read-write and let
+//                  correlate() write the ny x ny result straight into it
+//  --budget MB   = working-memory budget for --ooc and the compact outputs
+//                  (default 1024)
+//  --output FMT  = dense|packed|sparse|approx|topk (default dense).  The compact
+//                  formats never allocate the ny x ny matrix.
+//  --threshold T = |r| cut-off for --output sparse / approx (default 0.9)
+//  --lsh-bits B  = SimHash bits per table for --output approx (default 0:
+//                  from ny, 12 at ny = 20000; see lsh_bits())
+//  --lsh-tables L = SimHash tables for --output approx (default 32); recall
+//                  and precision are reported against the exact sparse
+//                  search when ny <= 20000
+//  --topk K      = partners kept per row for --output topk (default 10)
+//  --schedule S  = dynamic|triangle|all, how the openmp and vectorised
+//                  implementations split the triangle (default triangle)
+//  --load        = print per-thread active / idle time (as LAB2/eg11.cpp)
+//                  for the openmp, vectorised and blocked implementations
+//  --counters    = per-thread hardware counters of the blocked kernel's two
+//                  phases (normalise, tile dot-products), read in-process:
+//                  GFLOP/s, bytes per flop, IPC, L1D and LLC miss rates
+//  --json FILE   = also write those counters, per run, as JSON to FILE
+//                  (implies --counters)
+//  --append K    = incremental engine: start from the first ny-1 rows and
+//                  nx-K columns, append the last K columns and then the
+//                  last row, and compare with a full recompute
+//  --batch N     = N independent ny x nx jobs through correlate_batch(),
+//                  timed against a loop of correlate() calls
+//  --plan N      = bench mode: one correlate_plan_create(), then N plan
+//                  executions timed against N correlate() calls with the
+//                  same kernel (first --impl / --precision)
+//  --numa        = NUMA-aware mode: pinned threads, data and result
+//                  first-touched in parallel, per-node copies of the
+//                  normalised rows (blocked); prints per-socket operand
+//                  throughput
 //
-//  Timing is printed to stdout; use  perf stat ./correlate ...  to collect
-//  hardware-performance-counter data alongside it.
+//  CORRELATE_HUGEPAGES=0 stops large buffers being marked MADV_HUGEPAGE,
+//  CORRELATE_ISA=sse2|avx2 forces a lower kernel level (A/B runs).
+//
+//  Timing is printed to stdout; --counters reads hardware counters around
+//  the compute phases only, where  perf stat ./correlate ...  counts the
+//  whole process (fill, reference and verification included).
 // ─────────────────────────────────────────────────────────────────────────────
 
 static void print_usage(const char* prog) {
-    std::cerr << "Usage: " << prog << " <ny> <nx> [num_threads]\n"
+    std::cerr << "Usage: " << prog << " <ny> <nx> [num_threads] [options]\n"
               << "  ny           number of rows  (vectors)\n"
               << "  nx           number of columns (elements per vector)\n"
-              << "  num_threads  OpenMP thread count (default: system max)\n";
+              << "  num_threads  OpenMP thread count (default: system max)\n"
+              << "Options:\n"
+              << "  --impl auto|sequential|openmp|vectorised|blocked|syrk|all\n"
+              << "                                       (default: auto)\n"
+              << "  --precision double|mixed|float|all   (default: double)\n"
+              << "  --method pearson|spearman|kendall    (default: pearson)\n"
+              << "  --columns        correlate the columns (nx x nx result)\n"
+              << "  --nan F          NaN in a fraction F of cells, pairwise-complete mode\n"
+              << "  --ooc IN OUT     out-of-core: raw float32 file IN -> OUT\n"
+              << "  --input FILE     mmap raw float32 or .npy input (ny nx = 0 0: from .npy)\n"
+              << "  --save FILE      map the result file (raw or .npy) and write it in place\n"
+              << "  --budget MB      memory budget for --ooc / --output (default: 1024)\n"
+              << "  --output dense|packed|sparse|approx|topk   (default: dense)\n"
+              << "  --threshold T    |r| cut-off for sparse / approx output (default: 0.9)\n"
+              << "  --lsh-bits B     approx: SimHash bits per table (default: 0 = from ny)\n"
+              << "  --lsh-tables L   approx: SimHash tables (default: 32)\n"
+              << "  --topk K         partners per row for topk output (default: 10)\n"
+              << "  --schedule dynamic|triangle|all      (default: triangle)\n"
+              << "  --load           per-thread active / idle time (openmp, vectorised, blocked)\n"
+              << "  --counters       per-thread hardware counters per phase (blocked)\n"
+              << "  --json FILE      write the counters as JSON (implies --counters)\n"
+              << "  --append K       incremental: append K columns and 1 row, vs. full\n"
+              << "  --batch N        N jobs via correlate_batch() vs. a correlate() loop\n"
+              << "  --plan N         N executions of one plan vs. N correlate() calls\n"
+              << "  --numa           pin threads, first-touch buffers, per-node row copies\n";
+}
+
+static const char* impl_name(Impl i) {
+    switch (i) {
+    case Impl::Sequential: return "sequential";
+    case Impl::OpenMP:     return "openmp";
+    case Impl::Vectorised: return "vectorised";
+    case Impl::Blocked:    return "blocked";
+    case Impl::Syrk:       return "syrk";
+    default:               return "auto";
+    }
+}
+
+static bool parse_impl(const char* s, Impl& i) {
+    if      (!std::strcmp(s, "auto"))       i = Impl::Auto;
+    else if (!std::strcmp(s, "sequential")) i = Impl::Sequential;
+    else if (!std::strcmp(s, "openmp"))     i = Impl::OpenMP;
+    else if (!std::strcmp(s, "vectorised")) i = Impl::Vectorised;
+    else if (!std::strcmp(s, "blocked"))    i = Impl::Blocked;
+    else if (!std::strcmp(s, "syrk"))       i = Impl::Syrk;
+    else return false;
+    return true;
+}
+
+static const char* precision_name(Precision p) {
+    switch (p) {
+    case Precision::Float: return "float";
+    case Precision::Mixed: return "mixed";
+    default:               return "double";
+    }
+}
+
+static bool parse_precision(const char* s, Precision& p) {
+    if      (!std::strcmp(s, "double")) p = Precision::Double;
+    else if (!std::strcmp(s, "mixed"))  p = Precision::Mixed;
+    else if (!std::strcmp(s, "float"))  p = Precision::Float;
+    else return false;
+    return true;
 }
 
+static const char* schedule_name(Schedule s) {
+    return s == Schedule::Dynamic ? "dynamic" : "triangle";
+}
+
+static bool parse_schedule(const char* s, Schedule& sc) {
+    if      (!std::strcmp(s, "dynamic"))  sc = Schedule::Dynamic;
+    else if (!std::strcmp(s, "triangle")) sc = Schedule::Triangle;
+    else return false;
+    return true;
+}
+
+// Per-thread table in the spirit of LAB2/eg11.cpp: idle is the time a
+// thread spent at the closing barrier waiting for the slowest one.
+static void print_load(const LoadStats& l) {
+    double max_idle = 0, sum_idle = 0;
+    std::cout << " thread   active ms    idle ms   items  stolen\n";
+    for (size_t t = 0; t < l.active.size(); ++t) {
+        const double idle = std::max(0.0, l.wall - l.active[t]);
+        max_idle  = std::max(max_idle, idle);
+        sum_idle += idle;
+        std::cout << std::setw(7) << t
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(12) << l.active[t] * 1e3
+                  << std::setw(11) << idle * 1e3
+                  << std::setw(8)  << l.items[t]
+                  << std::setw(8)  << l.stolen[t] << "\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6)
+              << " idle time    = max " << max_idle * 1e3 << " ms, "
+              << 100.0 * sum_idle / (l.wall * l.active.size()) << "% of thread-time\n";
+}
+
+// One phase summed over the team.  Its wall time is the slowest thread's
+// share, so GFLOP/s is the team's rate, not the sum of thread rates.
+static PhaseCounters phase_total(const std::vector<PhaseCounters>& v) {
+    PhaseCounters t;
+    for (size_t i = 0; i < v.size(); ++i) {
+        t.seconds       = std::max(t.seconds, v[i].seconds);
+        t.cycles       += v[i].cycles;
+        t.instructions += v[i].instructions;
+        t.l1d_loads    += v[i].l1d_loads;
+        t.l1d_misses   += v[i].l1d_misses;
+        t.llc_refs     += v[i].llc_refs;
+        t.llc_misses   += v[i].llc_misses;
+        t.flops        += v[i].flops;
+        t.bytes        += v[i].bytes;
+    }
+    return t;
+}
+
+static double ratio(double a, double b) {
+    return b > 0 ? a / b : 0.0;
+}
+
+static void print_phase_row(const char* name, const PhaseCounters& p, bool hw) {
+    std::cout << std::setw(10) << name
+              << std::setw(10) << p.seconds * 1e3
+              << std::setw(9)  << ratio(p.flops, p.seconds) * 1e-9
+              << std::setw(8)  << ratio(p.bytes, p.flops);
+    if (hw)
+        std::cout << std::setw(7) << ratio(p.instructions, p.cycles)
+                  << std::setw(8) << 100 * ratio(p.l1d_misses, p.l1d_loads)
+                  << std::setw(8) << 100 * ratio(p.llc_misses, p.llc_refs);
+    else
+        std::cout << "    n/a     n/a     n/a";
+    std::cout << "\n";
+}
+
+static void print_counters(const CounterStats& c) {
+    const char* names[2] = { "normalise", "dot" };
+    const std::vector<PhaseCounters>* phases[2] = { &c.normalise, &c.dot };
+    std::cout << "     phase        ms   GFLOP/s  B/flop    IPC   L1D m%  LLC m%\n"
+              << std::fixed << std::setprecision(3);
+    for (int ph = 0; ph < 2; ++ph) {
+        print_phase_row(names[ph], phase_total(*phases[ph]), c.available);
+        if (phases[ph]->size() > 1)
+            for (size_t t = 0; t < phases[ph]->size(); ++t) {
+                const std::string label = "  t" + std::to_string(t);
+                print_phase_row(label.c_str(), (*phases[ph])[t], c.available);
+            }
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+    if (!c.available)
+        std::cout << " counters     = unavailable (perf_event_open refused; see"
+                     " /proc/sys/kernel/perf_event_paranoid)\n";
+}
+
+static void json_phase(std::ostream& o, const PhaseCounters& p, bool hw) {
+    o << "{\"seconds\": " << p.seconds << ", \"flops\": " << p.flops
+      << ", \"bytes\": " << p.bytes
+      << ", \"gflops\": " << ratio(p.flops, p.seconds) * 1e-9
+      << ", \"bytes_per_flop\": " << ratio(p.bytes, p.flops);
+    if (hw)
+        o << ", \"cycles\": " << p.cycles << ", \"instructions\": " << p.instructions
+          << ", \"ipc\": " << ratio(p.instructions, p.cycles)
+          << ", \"l1d_loads\": " << p.l1d_loads << ", \"l1d_misses\": " << p.l1d_misses
+          << ", \"l1d_miss_rate\": " << ratio(p.l1d_misses, p.l1d_loads)
+          << ", \"llc_refs\": " << p.llc_refs << ", \"llc_misses\": " << p.llc_misses
+          << ", \"llc_miss_rate\": " << ratio(p.llc_misses, p.llc_refs);
+    o << "}";
+}
+
+// One run: the team totals of each phase, then each thread's share.
+static void json_run(std::ostream& o, const CorrelateOptions& opt, double wall,
+                     const CounterStats& c) {
+    const char* names[2] = { "normalise", "dot" };
+    const std::vector<PhaseCounters>* phases[2] = { &c.normalise, &c.dot };
+    o << "    {\"impl\": \"" << impl_name(opt.impl) << "\", \"precision\": \""
+      << precision_name(opt.precision) << "\", \"wall_seconds\": " << wall
+      << ", \"counters_available\": " << (c.available ? "true" : "false");
+    for (int ph = 0; ph < 2; ++ph) {
+        o << ",\n     \"" << names[ph] << "\": {\"total\": ";
+        json_phase(o, phase_total(*phases[ph]), c.available);
+        o << ", \"threads\": [";
+        for (size_t t = 0; t < phases[ph]->size(); ++t) {
+            o << (t ? ",\n        " : "\n        ");
+            json_phase(o, (*phases[ph])[t], c.available);
+        }
+        o << "]}";
+    }
+    o << "}";
+}
+
+// Per-node operand throughput of the Task 4 tile kernels: bytes of
+// normalised rows handed to the node's threads over the parallel region's
+// wall time.  Rows reused from cache count every time, so this is not
+// memory bandwidth; LAB2/stream --per-socket measures that.
+static void print_node_throughput(const LoadStats& l) {
+    std::vector<double> bytes;
+    std::vector<int>    threads;
+    for (size_t t = 0; t < l.node.size(); ++t) {
+        const size_t n = (size_t)l.node[t];
+        if (n >= bytes.size()) {
+            bytes.resize(n + 1, 0.0);
+            threads.resize(n + 1, 0);
+        }
+        bytes[n]   += l.bytes[t];
+        threads[n] += 1;
+    }
+    for (size_t n = 0; n < bytes.size(); ++n)
+        if (threads[n])
+            std::cout << " socket " << n << "     = " << threads[n] << " threads, "
+                      << bytes[n] / l.wall * 1e-9 << " GB/s operand throughput\n";
+}
+
+// Input and result live in aligned_malloc memory (64-byte aligned, huge
+// pages when large).  Elements start uninitialised, so the pages are only
+// faulted in by whoever first writes them (correlate_first_touch, --numa).
+typedef aligned_vector<float> Buffer;
+
 // Simple pseudo-random fill so results are reproducible
-static void fill_matrix(int ny, int nx, std::vector<float>& mat) {
-    mat.resize((size_t)ny * nx);
+static void fill_matrix(int ny, int nx, Buffer& mat) {
     unsigned seed = 42;
-    for (int i = 0; i < ny * nx; ++i) {
+    for (size_t i = 0; i < (size_t)ny * nx; ++i) {
         seed = seed * 1664525u + 1013904223u;   // LCG
         mat[i] = (float)(int(seed & 0xFFFF) - 32768) / 32768.0f;
     }
 }
 
+// Same values as fill_matrix, streamed to a raw float32 file one row at a
+// time so that inputs larger than RAM can be produced for --ooc.
+static bool write_matrix_file(const char* path, int ny, int nx) {
+    FILE* f = std::fopen(path, "wb");
+    if (!f)
+        return false;
+    std::vector<float> row(nx);
+    unsigned seed = 42;
+    bool ok = true;
+    for (int y = 0; y < ny && ok; ++y) {
+        for (int x = 0; x < nx; ++x) {
+            seed = seed * 1664525u + 1013904223u;   // LCG
+            row[x] = (float)(int(seed & 0xFFFF) - 32768) / 32768.0f;
+        }
+        ok = std::fwrite(row.data(), sizeof(float), nx, f) == (size_t)nx;
+    }
+    return std::fclose(f) == 0 && ok;
+}
+
+// Read-only mapping of a whole file of `bytes` bytes (nullptr on failure).
+static const float* map_readonly(const char* path, size_t bytes) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    void* p = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (p == MAP_FAILED) ? nullptr : (const float*)p;
+}
+
 // Pretty-print a duration
 static void print_elapsed(const char* label,
                            std::chrono::high_resolution_clock::time_point t0,
@@ -44,61 +354,359 @@ static void print_elapsed(const char* label,
     std::cout << label << ": " << ms << " ms\n";
 }
 
-// Spot-check a few results against a naive reference (only for small matrices)
-static bool verify(int ny, int nx,
-                   const std::vector<float>& data,
-                   const std::vector<float>& result)
+// Naive double-precision Pearson r between rows i and j: the reference
+// every verification below compares against.
+static double reference_r(int nx, const float* data, int i, int j)
+{
+    // compute mean_i, mean_j over the columns where both are present
+    // (all of them unless --nan punched holes)
+    double si = 0, sj = 0;
+    int n = 0;
+    for (int x = 0; x < nx; ++x) {
+        if (std::isnan(data[x + (size_t)i * nx]) || std::isnan(data[x + (size_t)j * nx]))
+            continue;
+        si += data[x + (size_t)i * nx];
+        sj += data[x + (size_t)j * nx];
+        ++n;
+    }
+    if (n < 2)
+        return std::nan("");
+    double mi = si / n, mj = sj / n;
+
+    double num = 0, di2 = 0, dj2 = 0;
+    for (int x = 0; x < nx; ++x) {
+        if (std::isnan(data[x + (size_t)i * nx]) || std::isnan(data[x + (size_t)j * nx]))
+            continue;
+        double ai = data[x + (size_t)i * nx] - mi;
+        double aj = data[x + (size_t)j * nx] - mj;
+        num += ai * aj;
+        di2 += ai * ai;
+        dj2 += aj * aj;
+    }
+    double denom = std::sqrt(di2 * dj2);
+    return (denom > 0) ? num / denom : 0.0;
+}
+
+// Rank correlations by definition: Spearman as Pearson's r of mean ranks
+// (O(nx²) ranking), Kendall's tau-b by visiting every pair of columns.
+static std::vector<float> reference_ranks(int nx, const float* row)
+{
+    std::vector<float> r(nx);
+    for (int a = 0; a < nx; ++a) {
+        int below = 0, equal = 0;
+        for (int b = 0; b < nx; ++b) {
+            below += row[b] < row[a];
+            equal += row[b] == row[a];
+        }
+        r[a] = below + 0.5f * (equal + 1);
+    }
+    return r;
+}
+
+static double reference_spearman(int nx, const float* data, int i, int j)
 {
-    // Reference: naive double-precision correlate for a small subset
+    std::vector<float> two = reference_ranks(nx, data + (size_t)i * nx);
+    std::vector<float> rj  = reference_ranks(nx, data + (size_t)j * nx);
+    two.insert(two.end(), rj.begin(), rj.end());
+    return reference_r(nx, two.data(), 0, 1);
+}
+
+static double reference_kendall(int nx, const float* data, int i, int j)
+{
+    const float* a = data + (size_t)i * nx;
+    const float* b = data + (size_t)j * nx;
+    double con = 0, dis = 0, ta = 0, tb = 0;
+    for (int p = 0; p < nx; ++p)
+        for (int q = p + 1; q < nx; ++q) {
+            const double s = (double)(a[p] > a[q]) - (a[p] < a[q]);
+            const double t = (double)(b[p] > b[q]) - (b[p] < b[q]);
+            if (s * t > 0) con += 1;
+            if (s * t < 0) dis += 1;
+            if (s == 0 && t != 0) ta += 1;
+            if (t == 0 && s != 0) tb += 1;
+        }
+    const double den = std::sqrt((con + dis + ta) * (con + dis + tb));
+    return (den > 0) ? (con - dis) / den : 0.0;
+}
+
+static void track_error(double& max_err, int i, int j, double ref, double got)
+{
+    double err = std::fabs(ref - got);
+    if (err > 1e-4 && max_err <= 1e-4)
+        std::cerr << "VERIFY FAIL at (" << i << "," << j << "): "
+                  << "ref=" << ref << " got=" << got << "\n";
+    max_err = std::max(max_err, err);
+}
+
+// Spot-check a few results against a naive reference (only for small matrices).
+// got(i, j) returns the computed r for j <= i.  Returns the largest absolute
+// deviation seen; anything above 1e-4 is reported.
+template <class Get>
+static double verify_with(int ny, int nx, const float* data, Get got)
+{
+    double max_err = 0.0;
     const int CHECK = std::min(ny, 8);
-    for (int i = 0; i < CHECK; ++i) {
+    for (int i = 0; i < CHECK; ++i)
+        for (int j = 0; j <= i; ++j)
+            track_error(max_err, i, j, (float)reference_r(nx, data, i, j), got(i, j));
+    return max_err;
+}
+
+static double verify_rank(const std::string& method, int ny, int nx,
+                          const float* data, const float* result)
+{
+    double max_err = 0.0;
+    const int CHECK = std::min(ny, 8);
+    for (int i = 0; i < CHECK; ++i)
         for (int j = 0; j <= i; ++j) {
-            // compute mean_i, mean_j
-            double si = 0, sj = 0;
-            for (int x = 0; x < nx; ++x) {
-                si += data[x + i * nx];
-                sj += data[x + j * nx];
-            }
-            double mi = si / nx, mj = sj / nx;
-
-            double num = 0, di2 = 0, dj2 = 0;
-            for (int x = 0; x < nx; ++x) {
-                double ai = data[x + i * nx] - mi;
-                double aj = data[x + j * nx] - mj;
-                num += ai * aj;
-                di2 += ai * ai;
-                dj2 += aj * aj;
-            }
-            double denom = std::sqrt(di2 * dj2);
-            float ref = (denom > 0) ? (float)(num / denom) : 0.0f;
-            float got = result[i + j * ny];
-            if (std::fabs(ref - got) > 1e-4f) {
-                std::cerr << "VERIFY FAIL at (" << i << "," << j << "): "
-                          << "ref=" << ref << " got=" << got << "\n";
-                return false;
+            const double ref = (method == "kendall") ? reference_kendall(nx, data, i, j)
+                                                     : reference_spearman(nx, data, i, j);
+            track_error(max_err, i, j, (float)ref, result[i + (size_t)j * ny]);
+        }
+    return max_err;
+}
+
+static double verify(int ny, int nx, const float* data, const float* result)
+{
+    return verify_with(ny, nx, data, [&](int i, int j) { return result[i + (size_t)j * ny]; });
+}
+
+// Sparse output: every |r| > t cell of the first rows is present with the
+// right value, and nothing else is (cells within 1e-4 of t may go either way).
+static double verify_sparse(int ny, int nx, const float* data, float t,
+                            const SparseCorrelation& s)
+{
+    double max_err = 0.0;
+    const int CHECK = std::min(ny, 8);
+    for (int i = 0; i < CHECK; ++i) {
+        size_t e = s.row_ptr[i];
+        for (int j = 0; j < i; ++j) {
+            double ref = reference_r(nx, data, i, j);
+            bool stored = (e < s.row_ptr[i + 1] && s.col[e] == j);
+            if (stored)
+                track_error(max_err, i, j, ref, s.val[e++]);
+            else if (std::fabs(ref) > t + 1e-4)
+                track_error(max_err, i, j, ref, 0.0);   // missing entry
+        }
+        if (e != s.row_ptr[i + 1])
+            max_err = std::max(max_err, 1.0);           // stray entries
+    }
+    return max_err;
+}
+
+// Approximate vs. exact sparse output: recall is the share of the exact
+// pairs that were found, precision the share of reported pairs that are
+// exact ones.
+static void print_recall(const SparseCorrelation& exact, const SparseCorrelation& approx)
+{
+    size_t hits = 0;
+    for (size_t i = 0; i + 1 < exact.row_ptr.size(); ++i) {
+        size_t a = approx.row_ptr[i], e = exact.row_ptr[i];
+        while (a < approx.row_ptr[i + 1] && e < exact.row_ptr[i + 1]) {
+            if (approx.col[a] == exact.col[e]) {
+                ++hits;
+                ++a;
+                ++e;
+            } else if (approx.col[a] < exact.col[e]) {
+                ++a;
+            } else {
+                ++e;
             }
         }
     }
-    return true;
+    const size_t ne = exact.col.size(), na = approx.col.size();
+    std::cout << " exact pairs  = " << ne << "\n"
+              << " recall       = " << (ne ? (double)hits / ne : 1.0) << "\n"
+              << " precision    = " << (na ? (double)hits / na : 1.0) << "\n";
+}
+
+// Top-k output: the k-th strongest |r| of each checked row matches the
+// reference ranking, and every reported value matches its partner.
+static double verify_topk(int ny, int nx, const float* data, const TopK& tk)
+{
+    double max_err = 0.0;
+    const int CHECK = std::min(ny, 8);
+    for (int i = 0; i < CHECK; ++i) {
+        std::vector<double> ref;
+        for (int j = 0; j < ny; ++j)
+            if (j != i)
+                ref.push_back(std::fabs(reference_r(nx, data, i, j)));
+        std::sort(ref.rbegin(), ref.rend());
+        for (int e = 0; e < tk.k && e < (int)ref.size(); ++e) {
+            int j = tk.index[(size_t)i * tk.k + e];
+            float v = tk.value[(size_t)i * tk.k + e];
+            track_error(max_err, i, j, ref[e], std::fabs(v));
+            track_error(max_err, i, j, reference_r(nx, data, i, j), v);
+        }
+    }
+    return max_err;
+}
+
+static void print_verification(double err) {
+    std::cout << " Verification: " << (err <= 1e-4 ? "PASSED" : "FAILED")
+              << " (max |err| = " << err << ")\n";
 }
 
 int main(int argc, char* argv[])
 {
     // ── Parse arguments ───────────────────────────────────────────────────────
-    if (argc < 3) {
+    std::vector<const char*> pos;
+    std::vector<Precision> modes(1, Precision::Double);
+    std::vector<Impl> impls(1, Impl::Auto);
+    std::vector<Schedule> schedules(1, Schedule::Triangle);
+    bool show_load = false;
+    bool show_counters = false;
+    const char* json = nullptr;
+    bool numa = false;
+    int append = 0;
+    int batch = 0;
+    int plan_iters = 0;
+    const char* ooc_in  = nullptr;
+    const char* ooc_out = nullptr;
+    const char* input   = nullptr;
+    const char* save    = nullptr;
+    double budget_mb = 1024;
+    std::string output = "dense";
+    float threshold = 0.9f;
+    int topk = 10;
+    std::string method = "pearson";
+    bool columns = false;
+    double nan_frac = 0.0;
+    LshOptions lsh;
+    for (int a = 1; a < argc; ++a) {
+        if (!std::strcmp(argv[a], "--ooc") && a + 2 < argc) {
+            ooc_in  = argv[++a];
+            ooc_out = argv[++a];
+        } else if (!std::strcmp(argv[a], "--input") && a + 1 < argc) {
+            input = argv[++a];
+        } else if (!std::strcmp(argv[a], "--save") && a + 1 < argc) {
+            save = argv[++a];
+        } else if (!std::strcmp(argv[a], "--budget") && a + 1 < argc) {
+            budget_mb = std::atof(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--output") && a + 1 < argc) {
+            output = argv[++a];
+            if (output != "dense" && output != "packed" &&
+                output != "sparse" && output != "approx" && output != "topk") {
+                std::cerr << "Error: unknown output format '" << output << "'.\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (!std::strcmp(argv[a], "--threshold") && a + 1 < argc) {
+            threshold = (float)std::atof(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--nan") && a + 1 < argc) {
+            nan_frac = std::atof(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--method") && a + 1 < argc) {
+            method = argv[++a];
+            if (method != "pearson" && method != "spearman" && method != "kendall") {
+                std::cerr << "Error: unknown method '" << method << "'.\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (!std::strcmp(argv[a], "--columns")) {
+            columns = true;
+        } else if (!std::strcmp(argv[a], "--lsh-bits") && a + 1 < argc) {
+            lsh.bits = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--lsh-tables") && a + 1 < argc) {
+            lsh.tables = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--topk") && a + 1 < argc) {
+            topk = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--append") && a + 1 < argc) {
+            append = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--batch") && a + 1 < argc) {
+            batch = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--plan") && a + 1 < argc) {
+            plan_iters = std::atoi(argv[++a]);
+        } else if (!std::strcmp(argv[a], "--numa")) {
+            numa = true;
+        } else if (!std::strcmp(argv[a], "--load")) {
+            show_load = true;
+        } else if (!std::strcmp(argv[a], "--counters")) {
+            show_counters = true;
+        } else if (!std::strcmp(argv[a], "--json") && a + 1 < argc) {
+            json = argv[++a];
+            show_counters = true;
+        } else if (!std::strcmp(argv[a], "--schedule") && a + 1 < argc) {
+            const char* v = argv[++a];
+            Schedule sc;
+            if (!std::strcmp(v, "all")) {
+                schedules.assign(1, Schedule::Dynamic);
+                schedules.push_back(Schedule::Triangle);
+            } else if (parse_schedule(v, sc)) {
+                schedules.assign(1, sc);
+            } else {
+                std::cerr << "Error: unknown schedule '" << v << "'.\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (!std::strcmp(argv[a], "--impl") && a + 1 < argc) {
+            const char* v = argv[++a];
+            Impl i;
+            if (!std::strcmp(v, "all")) {
+                impls.assign(1, Impl::Sequential);
+                impls.push_back(Impl::OpenMP);
+                impls.push_back(Impl::Vectorised);
+                impls.push_back(Impl::Blocked);
+                impls.push_back(Impl::Syrk);
+            } else if (parse_impl(v, i)) {
+                impls.assign(1, i);
+            } else {
+                std::cerr << "Error: unknown implementation '" << v << "'.\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (!std::strcmp(argv[a], "--precision") && a + 1 < argc) {
+            const char* v = argv[++a];
+            Precision p;
+            if (!std::strcmp(v, "all")) {
+                modes.assign(1, Precision::Double);
+                modes.push_back(Precision::Mixed);
+                modes.push_back(Precision::Float);
+            } else if (parse_precision(v, p)) {
+                modes.assign(1, p);
+            } else {
+                std::cerr << "Error: unknown precision '" << v << "'.\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (argv[a][0] == '-' && argv[a][1] == '-') {
+            std::cerr << "Error: unknown option '" << argv[a] << "'.\n";
+            print_usage(argv[0]);
+            return 1;
+        } else {
+            pos.push_back(argv[a]);
+        }
+    }
+
+    if (pos.size() < 2) {
         print_usage(argv[0]);
         return 1;
     }
 
-    int ny = std::atoi(argv[1]);
-    int nx = std::atoi(argv[2]);
-    int num_threads = (argc >= 4) ? std::atoi(argv[3]) : omp_get_max_threads();
+    int ny = std::atoi(pos[0]);
+    int nx = std::atoi(pos[1]);
+    int num_threads = (pos.size() >= 3) ? std::atoi(pos[2]) : omp_get_max_threads();
+
+    // A mapped input may supply its own shape, so it is opened first.
+    MappedMatrix in;
+    auto tm0 = std::chrono::high_resolution_clock::now();
+    if (input && !map_matrix(input, std::max(ny, 0), std::max(nx, 0), true, in))
+        return 1;
+    auto tm1 = std::chrono::high_resolution_clock::now();
+    if (input) {
+        ny = in.ny;
+        nx = in.nx;
+    }
 
     if (ny <= 0 || nx <= 0 || num_threads <= 0) {
         std::cerr << "Error: ny, nx, and num_threads must be positive integers.\n";
         print_usage(argv[0]);
         return 1;
     }
+    if (append < 0 || (append > 0 && (append >= nx || ny < 2))) {
+        std::cerr << "Error: --append needs 0 < K < nx and ny >= 2.\n";
+        print_usage(argv[0]);
+        return 1;
+    }
 
     omp_set_num_threads(num_threads);
 
@@ -108,28 +716,508 @@ int main(int argc, char* argv[])
               << " ny           = " << ny          << "\n"
               << " nx           = " << nx          << "\n"
               << " num_threads  = " << num_threads << "\n"
+              << " kernel ISA   = " << correlate_isa() << "\n"
               << " result cells = " << (long long)ny * (ny + 1) / 2 << "\n"
+              << " huge pages   = " << (aligned_hugepages() ? "madvise" : "off") << "\n"
+              << " NUMA nodes   = " << correlate_numa_nodes()
+              << (numa ? " (pinned, first-touch)" : "") << "\n"
               << "──────────────────────────────────────────\n";
 
+    // ── Out-of-core: nothing ny-sized is allocated in this process ─────────
+    if (ooc_in) {
+        if (access(ooc_in, R_OK) != 0) {
+            std::cout << " synthesising " << ooc_in << "\n";
+            if (!write_matrix_file(ooc_in, ny, nx)) {
+                std::cerr << "Error: cannot write " << ooc_in << ".\n";
+                return 1;
+            }
+        }
+
+        StreamingOptions sopt;
+        sopt.memory_budget = (size_t)(budget_mb * 1024 * 1024);
+        sopt.precision     = modes[0];
+        std::cout << " out-of-core  = " << ooc_in << " -> " << ooc_out
+                  << " (budget " << budget_mb << " MB, "
+                  << precision_name(sopt.precision) << ")\n";
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        bool ok = correlate_file(ooc_in, ny, nx, ooc_out, sopt);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        if (!ok)
+            return 1;
+        print_elapsed(" correlate_file() wall time", t0, t1);
+
+        if (ny <= 512 && nx <= 512) {
+            const float* d = map_readonly(ooc_in,  (size_t)ny * nx * sizeof(float));
+            const float* r = map_readonly(ooc_out, (size_t)ny * ny * sizeof(float));
+            if (d && r) {
+                print_verification(verify(ny, nx, d, r));
+            }
+        } else {
+            std::cout << " Verification: skipped (matrix too large)\n";
+        }
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // ── Mapped files: input read and result written in place ──────────────
+    // (A mapped input with a compact --output is handled further down.)
+    if (save || (input && output == "dense")) {
+        Buffer synthetic;
+        const float* src = in.data;
+        if (!input) {
+            synthetic.resize((size_t)ny * nx);
+            fill_matrix(ny, nx, synthetic);
+            src = synthetic.data();
+        }
+
+        CorrelateOptions opt;
+        opt.impl      = impls[0] == Impl::Auto ? correlate_auto_impl(ny, nx, num_threads) : impls[0];
+        opt.precision = modes[0];
+        std::cout << " input        = " << (input ? input : "synthetic") << "\n"
+                  << " output       = " << (save ? save : "memory") << "\n"
+                  << " impl         = " << impl_name(opt.impl) << ", "
+                  << precision_name(opt.precision) << "\n";
+
+        MappedMatrix out;
+        Buffer heap;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (save) {
+            if (!create_matrix(save, ny, ny, out))
+                return 1;
+        } else {
+            heap.resize((size_t)ny * ny);
+        }
+        float* r = save ? out.data : heap.data();
+        auto t1 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, src, r, opt);
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        if (input)
+            print_elapsed(" map input (startup) ", tm0, tm1);
+        print_elapsed(" map output (startup)", t0, t1);
+        print_elapsed(" correlate() wall time", t1, t2);
+        if (ny <= 512 && nx <= 512)
+            print_verification(verify(ny, nx, src, r));
+        else
+            std::cout << " Verification: skipped (matrix too large)\n";
+
+        auto t3 = std::chrono::high_resolution_clock::now();
+        const bool ok = unmap_matrix(out);
+        auto t4 = std::chrono::high_resolution_clock::now();
+        if (save)
+            print_elapsed(" flush output        ", t3, t4);
+        unmap_matrix(in);
+        std::cout << "──────────────────────────────────────────\n";
+        return ok ? 0 : 1;
+    }
+
+    // ── Batch API: N jobs, one after another in memory ──────────────────────
+    if (batch > 0) {
+        const size_t in = (size_t)ny * nx, out = (size_t)ny * ny;
+        Buffer data(in * batch), r_loop(out * batch), r_batch(out * batch);
+        fill_matrix(ny * batch, nx, data);   // job b = rows [b*ny, (b+1)*ny)
+
+        std::vector<CorrelateJob> jobs(batch);
+        for (int b = 0; b < batch; ++b) {
+            jobs[b].ny     = ny;
+            jobs[b].nx     = nx;
+            jobs[b].data   = &data[b * in];
+            jobs[b].result = &r_batch[b * out];
+        }
+        CorrelateOptions opt;
+        opt.impl      = Impl::Blocked;
+        opt.precision = modes[0];
+        std::cout << " batch        = " << batch << " jobs, "
+                  << precision_name(opt.precision) << "\n";
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        for (int b = 0; b < batch; ++b)
+            correlate(ny, nx, &data[b * in], &r_loop[b * out], opt);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        correlate_batch(jobs.data(), batch, opt);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        print_elapsed(" correlate() loop wall time ", t0, t1);
+        print_elapsed(" correlate_batch() wall time", t1, t2);
+        std::cout << " jobs / s     = "
+                  << batch / std::chrono::duration<double>(t1 - t0).count() << " (loop), "
+                  << batch / std::chrono::duration<double>(t2 - t1).count() << " (batch)\n";
+
+        double diff = 0.0;
+        for (int b = 0; b < batch; ++b)
+            for (int j = 0; j < ny; ++j)
+                for (int i = j; i < ny; ++i)
+                    diff = std::max(diff, (double)std::fabs(r_batch[b * out + i + (size_t)j * ny] -
+                                                            r_loop[b * out + i + (size_t)j * ny]));
+        std::cout << " max |batch - loop| = " << diff << "\n";
+        if (ny <= 512 && nx <= 512)
+            print_verification(std::max(diff, verify(ny, nx, &data[(batch - 1) * in],
+                                                     &r_batch[(batch - 1) * out])));
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
     // ── Allocate & fill input matrix ─────────────────────────────────────────
-    std::vector<float> data, result((size_t)ny * ny, 0.0f);
-    fill_matrix(ny, nx, data);
+    // Under --numa the pages are placed by the pinned team before the
+    // sequential fill writes them; otherwise the fill places them.
+    Buffer data(input ? 0 : (size_t)ny * nx);
+    if (!input) {
+        if (numa)
+            correlate_first_touch(data.data(), ny, nx);
+        fill_matrix(ny, nx, data);
+    }
+    const float* src = input ? in.data : data.data();
+
+    // ── Compact output formats: no dense ny x ny buffer ─────────────────────
+    if (output != "dense") {
+        StreamingOptions sopt;
+        sopt.memory_budget = (size_t)(budget_mb * 1024 * 1024);
+        sopt.precision     = modes[0];
+        const bool check = (ny <= 512 && nx <= 512);
+        std::cout << " output       = " << output << "\n";
 
-    // ── Run & time correlate() ────────────────────────────────────────────────
-    auto t0 = std::chrono::high_resolution_clock::now();
-    correlate(ny, nx, data.data(), result.data());
-    auto t1 = std::chrono::high_resolution_clock::now();
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (output == "packed") {
+            std::vector<float> packed(packed_index(ny, 0));
+            correlate_packed(ny, nx, src, packed.data(), sopt);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            print_elapsed(" correlate_packed() wall time", t0, t1);
+            std::cout << " output bytes = " << packed.size() * sizeof(float) << "\n";
+            if (check)
+                print_verification(verify_with(ny, nx, src, [&](int i, int j) {
+                    return packed[packed_index(i, j)];
+                }));
+        } else if (output == "sparse") {
+            SparseCorrelation sp;
+            correlate_threshold(ny, nx, src, threshold, sp, sopt);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            print_elapsed(" correlate_threshold() wall time", t0, t1);
+            std::cout << " |r| > " << threshold << "   = " << sp.col.size() << " pairs\n"
+                      << " output bytes = " << sp.row_ptr.size() * sizeof(size_t)
+                                             + sp.col.size() * (sizeof(int) + sizeof(float)) << "\n";
+            if (check)
+                print_verification(verify_sparse(ny, nx, src, threshold, sp));
+        } else if (output == "approx") {
+            SparseCorrelation sp;
+            const size_t cand = correlate_approx(ny, nx, src, threshold, sp, lsh);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            print_elapsed(" correlate_approx() wall time", t0, t1);
+            std::cout << " LSH          = " << lsh.tables << " tables x "
+                      << (lsh.bits > 0 ? lsh.bits : lsh_bits(ny)) << " bits\n"
+                      << " candidates   = " << cand << " ("
+                      << 100.0 * cand / (0.5 * ny * (ny - 1.0)) << "% of pairs)\n"
+                      << " |r| > " << threshold << "   = " << sp.col.size() << " pairs\n";
+            if (ny <= 20000) {
+                SparseCorrelation ex;
+                t0 = std::chrono::high_resolution_clock::now();
+                correlate_threshold(ny, nx, src, threshold, ex, sopt);
+                t1 = std::chrono::high_resolution_clock::now();
+                print_elapsed(" correlate_threshold() wall time", t0, t1);
+                print_recall(ex, sp);
+            } else {
+                std::cout << " Recall: skipped (ny > 20000)\n";
+            }
+        } else {
+            TopK tk;
+            correlate_topk(ny, nx, src, topk, tk, sopt);
+            auto t1 = std::chrono::high_resolution_clock::now();
+            print_elapsed(" correlate_topk() wall time", t0, t1);
+            std::cout << " output bytes = " << tk.index.size() * (sizeof(int) + sizeof(float)) << "\n";
+            if (topk > 0 && ny > 1)
+                std::cout << " row 0 best   = row " << tk.index[0] << " (r = " << tk.value[0] << ")\n";
+            if (check)
+                print_verification(verify_topk(ny, nx, src, tk));
+        }
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
 
-    print_elapsed(" correlate() wall time", t0, t1);
+    Buffer result((size_t)ny * ny);
+    if (numa)
+        correlate_first_touch(result.data(), ny, ny);
 
-    // ── Verify (only practical for small matrices) ────────────────────────────
-    if (ny <= 512 && nx <= 512) {
-        if (verify(ny, nx, data, result))
-            std::cout << " Verification: PASSED\n";
+    // ── Incremental engine vs. a full recompute ─────────────────────────────
+    if (append > 0) {
+        const int ny0 = ny - 1, nx0 = nx - append;
+        std::vector<float> base((size_t)ny0 * nx0), cols((size_t)ny0 * append);
+        for (int y = 0; y < ny0; ++y) {
+            const float* row = &data[(size_t)y * nx];
+            std::copy(row, row + nx0, &base[(size_t)y * nx0]);
+            std::copy(row + nx0, row + nx, &cols[(size_t)y * append]);
+        }
+        std::cout << " incremental  = " << ny0 << " x " << nx0 << " + "
+                  << append << " columns + 1 row\n";
+
+        IncrementalCorrelation inc;
+        auto t0 = std::chrono::high_resolution_clock::now();
+        incremental_init(inc, ny0, nx0, base.data());
+        auto t1 = std::chrono::high_resolution_clock::now();
+        incremental_append_columns(inc, append, cols.data());
+        auto t2 = std::chrono::high_resolution_clock::now();
+        incremental_append_row(inc, &data[(size_t)ny0 * nx]);
+        auto t3 = std::chrono::high_resolution_clock::now();
+        incremental_result(inc, result.data());
+        auto t4 = std::chrono::high_resolution_clock::now();
+        print_elapsed(" incremental_init()           ", t0, t1);
+        print_elapsed(" incremental_append_columns() ", t1, t2);
+        print_elapsed(" incremental_append_row()     ", t2, t3);
+        print_elapsed(" incremental_result()         ", t3, t4);
+
+        std::vector<float> full((size_t)ny * ny);
+        t0 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, data.data(), full.data());
+        t1 = std::chrono::high_resolution_clock::now();
+        print_elapsed(" full correlate()             ", t0, t1);
+
+        double diff = 0.0;
+        for (int j = 0; j < ny; ++j)
+            for (int i = j; i < ny; ++i)
+                diff = std::max(diff, (double)std::fabs(result[i + (size_t)j * ny] -
+                                                        full[i + (size_t)j * ny]));
+        std::cout << " max |incremental - full| = " << diff << "\n";
+        print_verification(std::max(diff, verify(ny, nx, data.data(), result.data())));
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // ── Missing values: pairwise-complete r ─────────────────────────────────
+    if (nan_frac > 0) {
+        CorrelateOptions opt;
+        opt.missing = true;
+
+        std::vector<float> scratch((size_t)ny * ny);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, data.data(), scratch.data());
+        auto t1 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, data.data(), scratch.data(), opt);
+        auto t2 = std::chrono::high_resolution_clock::now();
+
+        // Same LCG as fill_matrix, separate stream.
+        unsigned seed = 7;
+        size_t holes = 0;
+        for (size_t c = 0; c < (size_t)ny * nx; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            if ((seed >> 8) < nan_frac * (1u << 24)) {
+                data[c] = std::nanf("");
+                ++holes;
+            }
+        }
+        std::cout << " missing      = " << holes << " NaN cells ("
+                  << 100.0 * holes / ((double)ny * nx) << "%)\n";
+
+        auto t3 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, data.data(), result.data(), opt);
+        auto t4 = std::chrono::high_resolution_clock::now();
+        print_elapsed(" dense correlate(), no NaN   ", t0, t1);
+        print_elapsed(" pairwise-complete, no NaN   ", t1, t2);
+        print_elapsed(" pairwise-complete, with NaN ", t3, t4);
+
+        if (ny <= 512 && nx <= 512)
+            print_verification(verify(ny, nx, data.data(), result.data()));
+        else
+            std::cout << " Verification: skipped (matrix too large)\n";
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // ── Rank correlations ───────────────────────────────────────────────────
+    if (method != "pearson") {
+        CorrelateOptions opt;
+        opt.impl      = impls[0];
+        opt.precision = modes[0];
+        std::cout << " method       = " << method << "\n";
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        if (method == "spearman")
+            correlate_spearman(ny, nx, data.data(), result.data(), opt);
+        else
+            correlate_kendall(ny, nx, data.data(), result.data());
+        auto t1 = std::chrono::high_resolution_clock::now();
+        print_elapsed(method == "spearman" ? " correlate_spearman() wall time"
+                                           : " correlate_kendall() wall time", t0, t1);
+
+        if (ny <= 512 && nx <= 512)
+            print_verification(verify_rank(method, ny, nx, data.data(), result.data()));
+        else
+            std::cout << " Verification: skipped (matrix too large)\n";
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // ── Column correlations: transpose, then the row kernels ────────────────
+    if (columns) {
+        CorrelateOptions opt;
+        opt.impl      = impls[0];
+        opt.precision = modes[0];
+        std::cout << " columns      = " << nx << " (result " << nx << " x " << nx << ")\n";
+
+        aligned_vector<float> cols((size_t)nx * ny, 0.0f);   // as correlate_columns(), pages touched
+        std::vector<float> r((size_t)nx * nx);
+        auto t0 = std::chrono::high_resolution_clock::now();
+        transpose(ny, nx, data.data(), nx, cols.data(), ny);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        correlate_columns(ny, nx, data.data(), r.data(), opt);
+        auto t2 = std::chrono::high_resolution_clock::now();
+        const std::string label = " transpose() [" + std::string(transpose_isa()) + "]";
+        print_elapsed((label + std::string(std::max<int>(1, 30 - (int)label.size()), ' ')).c_str(), t0, t1);
+        print_elapsed(" correlate_columns() wall time", t1, t2);
+
+        // The transpose against plain loops, then r against the reference
+        // on those rows.
+        double diff = 0.0;
+        for (int y = 0; y < ny; ++y)
+            for (int x = 0; x < nx; ++x)
+                if (cols[(size_t)x * ny + y] != data[(size_t)y * nx + x])
+                    diff = 1.0;
+        if (nx <= 512 && ny <= 512)
+            print_verification(std::max(diff, verify(nx, ny, cols.data(), r.data())));
         else
-            std::cout << " Verification: FAILED\n";
-    } else {
-        std::cout << " Verification: skipped (matrix too large)\n";
+            print_verification(diff);
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // ── Plan bench: set-up paid once vs. on every call ──────────────────────
+    if (plan_iters > 0) {
+        CorrelateOptions opt;
+        opt.impl      = impls[0];
+        opt.precision = modes[0];
+
+        auto t0 = std::chrono::high_resolution_clock::now();
+        CorrelatePlan* plan = correlate_plan_create(ny, nx, opt);
+        auto t1 = std::chrono::high_resolution_clock::now();
+        opt.impl = correlate_plan_impl(plan);   // same kernel in both loops
+        std::cout << " plan         = " << impl_name(opt.impl) << ", "
+                  << precision_name(opt.precision) << ", " << plan_iters << " iterations\n";
+        print_elapsed(" correlate_plan_create()    ", t0, t1);
+
+        Buffer ref((size_t)ny * ny);
+        double best_call = 1e30, best_plan = 1e30;
+        t0 = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < plan_iters; ++it) {
+            auto a = std::chrono::high_resolution_clock::now();
+            correlate(ny, nx, data.data(), ref.data(), opt);
+            auto b = std::chrono::high_resolution_clock::now();
+            best_call = std::min(best_call, std::chrono::duration<double, std::milli>(b - a).count());
+        }
+        t1 = std::chrono::high_resolution_clock::now();
+        for (int it = 0; it < plan_iters; ++it) {
+            auto a = std::chrono::high_resolution_clock::now();
+            correlate_plan_execute(plan, data.data(), result.data());
+            auto b = std::chrono::high_resolution_clock::now();
+            best_plan = std::min(best_plan, std::chrono::duration<double, std::milli>(b - a).count());
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        correlate_plan_destroy(plan);
+
+        print_elapsed(" correlate() x N wall time  ", t0, t1);
+        print_elapsed(" plan execute x N wall time ", t1, t2);
+        std::cout << " per call     = "
+                  << std::chrono::duration<double, std::milli>(t1 - t0).count() / plan_iters
+                  << " ms (correlate), "
+                  << std::chrono::duration<double, std::milli>(t2 - t1).count() / plan_iters
+                  << " ms (plan)\n"
+                  << " best call    = " << best_call << " ms (correlate), "
+                  << best_plan << " ms (plan)\n";
+
+        double diff = 0.0;
+        for (int j = 0; j < ny; ++j)
+            for (int i = j; i < ny; ++i)
+                diff = std::max(diff, (double)std::fabs(result[i + (size_t)j * ny] -
+                                                        ref[i + (size_t)j * ny]));
+        std::cout << " max |plan - correlate| = " << diff << "\n";
+        if (ny <= 512 && nx <= 512)
+            print_verification(std::max(diff, verify(ny, nx, data.data(), result.data())));
+        std::cout << "──────────────────────────────────────────\n";
+        return 0;
+    }
+
+    // Every (implementation, precision) pair requested; only the blocked
+    // and SYRK kernels have a precision knob, and only Tasks 2 and 3 a
+    // schedule, so each implementation loops over at most one of them.
+    LoadStats load;
+    CounterStats counters;
+    std::vector<CorrelateOptions> runs;
+    for (size_t v = 0; v < impls.size(); ++v) {
+        CorrelateOptions opt;
+        opt.impl = impls[v];
+        if (opt.impl == Impl::Auto)
+            opt.impl = correlate_auto_impl(ny, nx, num_threads);
+        opt.numa = numa;
+        if (show_load || (numa && opt.impl == Impl::Blocked))
+            opt.load = &load;
+        if (show_counters && opt.impl == Impl::Blocked)
+            opt.counters = &counters;
+        if (opt.impl == Impl::OpenMP || opt.impl == Impl::Vectorised) {
+            for (size_t s = 0; s < schedules.size(); ++s) {
+                opt.schedule = schedules[s];
+                runs.push_back(opt);
+            }
+            continue;
+        }
+        for (size_t m = 0; m < modes.size(); ++m) {
+            opt.precision = modes[m];
+            runs.push_back(opt);
+            if (opt.impl != Impl::Blocked && opt.impl != Impl::Syrk)
+                break;
+        }
+    }
+
+    std::ofstream json_out;
+    if (json) {
+        json_out.open(json);
+        if (!json_out) {
+            std::cerr << "Error: cannot write " << json << ".\n";
+            return 1;
+        }
+        json_out << "{\"ny\": " << ny << ", \"nx\": " << nx << ", \"threads\": " << num_threads
+                 << ", \"isa\": \"" << correlate_isa() << "\",\n  \"runs\": [";
+    }
+    int json_runs = 0;
+
+    for (size_t r = 0; r < runs.size(); ++r) {
+        const CorrelateOptions& opt = runs[r];
+        std::cout << " impl         = " << impl_name(opt.impl)
+                  << (impls[0] == Impl::Auto ? " (auto)" : "") << "\n";
+        if (opt.impl == Impl::Blocked || opt.impl == Impl::Syrk)
+            std::cout << " precision    = " << precision_name(opt.precision) << "\n";
+        if (opt.impl == Impl::Syrk)
+            std::cout << " SYRK backend = " << correlate_syrk_backend() << "\n";
+        if (opt.impl == Impl::OpenMP || opt.impl == Impl::Vectorised)
+            std::cout << " schedule     = " << schedule_name(opt.schedule) << "\n";
+
+        // ── Run & time correlate() ────────────────────────────────────────────
+        std::fill(result.begin(), result.end(), 0.0f);   // no stale cells
+        load = LoadStats();
+        counters = CounterStats();
+        auto t0 = std::chrono::high_resolution_clock::now();
+        correlate(ny, nx, data.data(), result.data(), opt);
+        auto t1 = std::chrono::high_resolution_clock::now();
+
+        print_elapsed(" correlate() wall time", t0, t1);
+        if (show_load && opt.load && !load.active.empty())
+            print_load(load);
+        if (opt.counters) {
+            print_counters(counters);
+            if (json) {
+                json_out << (json_runs++ ? ",\n" : "\n");
+                json_run(json_out, opt, std::chrono::duration<double>(t1 - t0).count(), counters);
+            }
+        }
+        if (numa && opt.impl == Impl::Blocked)
+            print_node_throughput(load);
+
+        // ── Verify (only practical for small matrices) ────────────────────────
+        if (ny <= 512 && nx <= 512) {
+            print_verification(verify(ny, nx, data.data(), result.data()));
+        } else {
+            std::cout << " Verification: skipped (matrix too large)\n";
+        }
+    }
+
+    if (json) {
+        json_out << "\n  ]}\n";
+        std::cout << " counters     -> " << json << " (" << json_runs << " runs)\n";
     }
 
     // ── Print a small corner of the result for sanity ─────────────────────────
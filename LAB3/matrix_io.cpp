@@ -0,0 +1,204 @@
+#include "functions.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  MATRIX FILES
+//
+//  Inputs of several GB are mapped, not read: the kernels normalise straight
+//  out of the page cache, so there is no parse and no heap copy.  A .npy
+//  file is the same float32 block behind a short text header, which is
+//  parsed only for its dtype, order and shape; the data offset is a
+//  multiple of 16 bytes, so float loads stay aligned to their size.
+//  Results are written the same way: the output file is created at its
+//  final length, mapped read-write and handed to correlate() as `result`.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const char   NPY_MAGIC[]  = "\x93NUMPY";
+static const size_t NPY_PREAMBLE = 10;   // magic, version, 16-bit header length (1.0)
+static const size_t NPY_ALIGN    = 64;   // header padding used by NumPy >= 1.14
+
+static bool is_npy(const char* path)
+{
+    const size_t n = std::strlen(path);
+    return n >= 4 && !std::strcmp(path + n - 4, ".npy");
+}
+
+// Text after `key` in the header dict ("'descr': '<f4', ..."), or nullptr.
+static const char* npy_field(const std::string& header, const char* key)
+{
+    const size_t at = header.find(key);
+    if (at == std::string::npos)
+        return nullptr;
+    const char* p = header.c_str() + at + std::strlen(key);
+    while (*p == ' ' || *p == ':')
+        ++p;
+    return p;
+}
+
+/**
+ * Parse the header of a .npy file of `size` bytes at `p`: format 1.0 to
+ * 3.0, dtype '<f4' (float32, little endian), C order, two dimensions.
+ * Sets the shape and the byte offset of the data.
+ */
+static bool parse_npy(const char* path, const unsigned char* p, size_t size,
+                      int& ny, int& nx, size_t& offset)
+{
+    if (size < NPY_PREAMBLE || std::memcmp(p, NPY_MAGIC, 6) != 0) {
+        std::fprintf(stderr, "correlate: %s is not a .npy file\n", path);
+        return false;
+    }
+    size_t len, start;
+    if (p[6] == 1) {
+        len   = p[8] | (size_t)p[9] << 8;
+        start = 10;
+    } else {
+        len   = p[8] | (size_t)p[9] << 8 | (size_t)p[10] << 16 | (size_t)p[11] << 24;
+        start = 12;
+    }
+    if (start + len > size) {
+        std::fprintf(stderr, "correlate: %s: truncated .npy header\n", path);
+        return false;
+    }
+    const std::string header((const char*)p + start, len);
+
+    const char* descr = npy_field(header, "'descr'");
+    const char* order = npy_field(header, "'fortran_order'");
+    const char* shape = npy_field(header, "'shape'");
+    if (!descr || std::strncmp(descr, "'<f4'", 5) != 0) {
+        std::fprintf(stderr, "correlate: %s: dtype must be float32 ('<f4')\n", path);
+        return false;
+    }
+    if (!order || std::strncmp(order, "False", 5) != 0) {
+        std::fprintf(stderr, "correlate: %s: array must be in C order\n", path);
+        return false;
+    }
+    long rows = 0, cols = 0;
+    if (!shape || std::sscanf(shape, "(%ld , %ld )", &rows, &cols) != 2
+        || rows <= 0 || cols <= 0 || rows > 0x7fffffff || cols > 0x7fffffff) {
+        std::fprintf(stderr, "correlate: %s: shape must be (ny, nx)\n", path);
+        return false;
+    }
+    ny     = (int)rows;
+    nx     = (int)cols;
+    offset = start + len;
+    return true;
+}
+
+bool map_matrix(const char* path, int ny, int nx, bool populate, MappedMatrix& m)
+{
+    if (!is_npy(path) && (ny <= 0 || nx <= 0)) {
+        std::fprintf(stderr, "correlate: raw input %s needs ny and nx\n", path);
+        return false;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        std::fprintf(stderr, "correlate: cannot open %s: %s\n", path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        std::fprintf(stderr, "correlate: %s is empty\n", path);
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t)st.st_size;
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED | (populate ? MAP_POPULATE : 0), fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::fprintf(stderr, "correlate: cannot mmap %s: %s\n", path, std::strerror(errno));
+        return false;
+    }
+
+    int    rows = ny, cols = nx;
+    size_t offset = 0;
+    bool   ok = true;
+    if (is_npy(path)) {
+        ok = parse_npy(path, (const unsigned char*)base, size, rows, cols, offset);
+        if (ok && ((ny > 0 && ny != rows) || (nx > 0 && nx != cols))) {
+            std::fprintf(stderr, "correlate: %s holds %d x %d, not %d x %d\n",
+                         path, rows, cols, ny, nx);
+            ok = false;
+        }
+    }
+    if (ok && (rows <= 0 || cols <= 0 || offset + (size_t)rows * cols * sizeof(float) > size)) {
+        std::fprintf(stderr, "correlate: %s is smaller than %d x %d floats\n", path, rows, cols);
+        ok = false;
+    }
+    if (!ok) {
+        munmap(base, size);
+        return false;
+    }
+
+    // Rows are read front to back, once per pass.
+    madvise(base, size, MADV_SEQUENTIAL);
+    m.ny       = rows;
+    m.nx       = cols;
+    m.data     = (float*)((char*)base + offset);
+    m.base     = base;
+    m.bytes    = size;
+    m.writable = false;
+    return true;
+}
+
+bool create_matrix(const char* path, int ny, int nx, MappedMatrix& m)
+{
+    std::string header;
+    if (is_npy(path)) {
+        char dict[128];
+        std::snprintf(dict, sizeof dict,
+                      "{'descr': '<f4', 'fortran_order': False, 'shape': (%d, %d), }", ny, nx);
+        header = dict;
+        const size_t total = (NPY_PREAMBLE + header.size() + 1 + NPY_ALIGN - 1) / NPY_ALIGN * NPY_ALIGN;
+        header.resize(total - NPY_PREAMBLE - 1, ' ');
+        header += '\n';
+        const size_t len = header.size();
+        header = std::string(NPY_MAGIC, 6) + '\x01' + '\x00'
+               + (char)(len & 0xff) + (char)(len >> 8) + header;
+    }
+    const size_t size = header.size() + (size_t)ny * nx * sizeof(float);
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || ftruncate(fd, (off_t)size) != 0) {
+        std::fprintf(stderr, "correlate: cannot create %s: %s\n", path, std::strerror(errno));
+        if (fd >= 0)
+            close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::fprintf(stderr, "correlate: cannot mmap %s: %s\n", path, std::strerror(errno));
+        return false;
+    }
+    std::memcpy(base, header.data(), header.size());
+
+    m.ny       = ny;
+    m.nx       = nx;
+    m.data     = (float*)((char*)base + header.size());
+    m.base     = base;
+    m.bytes    = size;
+    m.writable = true;
+    return true;
+}
+
+bool unmap_matrix(MappedMatrix& m)
+{
+    if (!m.base)
+        return true;
+    bool ok = true;
+    if (m.writable && msync(m.base, m.bytes, MS_SYNC) != 0) {
+        std::fprintf(stderr, "correlate: msync failed: %s\n", std::strerror(errno));
+        ok = false;
+    }
+    munmap(m.base, m.bytes);
+    m = MappedMatrix();
+    return ok;
+}
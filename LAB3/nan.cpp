@@ -0,0 +1,189 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  MISSING VALUES — pairwise-complete Pearson (CorrelateOptions::missing)
+//
+//  A NaN marks a missing observation.  r(i, j) then uses only the set V of
+//  columns where both rows are present, with V's own means:
+//
+//    r = (n Σab - Σa Σb) / √((n Σa² - (Σa)²)(n Σb² - (Σb)²))    over V
+//
+//  Every row is centred on the mean of its own valid values and scaled to
+//  unit length; missing values are stored as 0, with one validity bit per
+//  column (64 per word) kept alongside.  Then:
+//
+//    Σab over V   is the plain dot-product of the rows (zeros drop out), so
+//                 every pair goes through the dense Task 4 tile kernels;
+//    Σa  over V   is Σa over row i's own values (≈ 0) minus Σa where row j
+//                 is missing; likewise Σb, Σa², Σb².
+//
+//  Pairs of rows without NaNs need no correction at all.  Otherwise the
+//  cheaper of two routes is taken per pair:
+//
+//    sparse   gather row i at row j's missing columns and vice versa: a few
+//             loads per NaN, best while the NaNs are scattered
+//    words    the mask words where either row has a gap, through a SIMD
+//             kernel that applies both masks in-register, 64 columns per
+//             word; best once the gaps are dense or come in runs
+//
+//  Padding bits are set, so padding never counts as a gap.
+// ─────────────────────────────────────────────────────────────────────────────
+
+typedef unsigned long long Word;
+
+// Gathers per NaN that cost about as much as one masked word (64 columns).
+static const size_t SPARSE_PER_WORD = 8;
+
+void correlate_pairwise(int ny, int nx, const float* data, float* result)
+{
+    const int stride = padded_stride<double>(nx);
+    const int words  = (stride + 63) / 64;
+    const int nt     = (ny + TILE - 1) / TILE;
+
+    AlignedMatrix<double> norm(nt * TILE, nx, stride);
+    std::vector<Word>     valid((size_t)ny * words, ~0ull);
+    std::vector<double>   sum(ny), sq(ny);
+    std::vector<std::vector<int> > gaps(ny);   // words with a missing value
+    std::vector<std::vector<int> > miss(ny);   // missing columns
+
+    // Each row is zeroed by the thread that normalises it (static split,
+    // as normalise_rows), so NaN cells and padding rows stay 0 and the
+    // pages are first touched in parallel.
+#pragma omp parallel for schedule(static)
+    for (int y = 0; y < norm.rows(); ++y) {
+        double* out = norm.row(y);
+        std::fill(out, out + stride, 0.0);
+        if (y >= ny)
+            continue;
+
+        const float* row = data + (size_t)y * nx;
+        Word*        bit = &valid[(size_t)y * words];
+
+        double s = 0.0;
+        int    n = 0;
+        for (int x = 0; x < nx; ++x)
+            if (!std::isnan(row[x])) {
+                s += row[x];
+                ++n;
+            }
+        const double mean = n ? s / n : 0.0;
+        double q = 0.0;
+        for (int x = 0; x < nx; ++x)
+            if (!std::isnan(row[x]))
+                q += (row[x] - mean) * (row[x] - mean);
+        const double inv = (q > 0.0) ? 1.0 / std::sqrt(q) : 0.0;
+
+        double s1 = 0.0, s2 = 0.0;
+        for (int x = 0; x < nx; ++x) {
+            if (std::isnan(row[x])) {
+                bit[x >> 6] &= ~(1ull << (x & 63));
+                miss[y].push_back(x);
+                continue;
+            }
+            out[x] = (row[x] - mean) * inv;
+            s1 += out[x];
+            s2 += out[x] * out[x];
+        }
+        sum[y] = s1;
+        sq[y]  = s2;
+        for (int w = 0; w < words; ++w)
+            if (bit[w] != ~0ull)
+                gaps[y].push_back(w);
+    }
+
+    std::vector<int> tiles;   // (I, J) tile pairs, J <= I
+    for (int bi = 0; bi < nt; ++bi)
+        for (int bj = 0; bj <= bi; ++bj) {
+            tiles.push_back(bi);
+            tiles.push_back(bj);
+        }
+    const int          ntiles = (int)tiles.size() / 2;
+    const KernelTable& k      = select_kernels();
+    const float        none   = std::numeric_limits<float>::quiet_NaN();
+
+#pragma omp parallel
+    {
+        aligned_vector<double> acc(TILE * TILE);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < ntiles; ++t) {
+            const int i0 = tiles[2 * t] * TILE;
+            const int j0 = tiles[2 * t + 1] * TILE;
+            const bool diag = (i0 == j0);
+            k.tile_f64(norm.row(i0), norm.row(j0), stride, diag, acc.data());
+
+            const int iend = std::min(i0 + TILE, ny);
+            for (int i = i0; i < iend; ++i) {
+                const int jend = diag ? i + 1 : std::min(j0 + TILE, ny);
+                for (int j = j0; j < jend; ++j) {
+                    const double ab = acc[(i - i0) * TILE + (j - j0)];
+                    const std::vector<int>& gi = gaps[i];
+                    const std::vector<int>& gj = gaps[j];
+                    if (gi.empty() && gj.empty()) {
+                        result[i + (size_t)j * ny] = (nx > 1) ? clamp_r(ab) : none;
+                        continue;
+                    }
+
+                    const Word*   mi = &valid[(size_t)i * words];
+                    const Word*   mj = &valid[(size_t)j * words];
+                    const double* zi = norm.row(i);
+                    const double* zj = norm.row(j);
+                    const std::vector<int>& xi = miss[i];
+                    const std::vector<int>& xj = miss[j];
+                    double s[4] = { 0.0, 0.0, 0.0, 0.0 };
+                    int    lost = 0;
+                    if (xi.size() + xj.size() <= SPARSE_PER_WORD * (gi.size() + gj.size())) {
+                        int shared = 0;
+                        for (size_t p = 0; p < xj.size(); ++p) {
+                            const int x = xj[p];
+                            s[0] += zi[x];
+                            s[2] += zi[x] * zi[x];
+                            shared += !(mi[x >> 6] >> (x & 63) & 1);
+                        }
+                        for (size_t p = 0; p < xi.size(); ++p) {
+                            const int x = xi[p];
+                            s[1] += zj[x];
+                            s[3] += zj[x] * zj[x];
+                        }
+                        lost = (int)(xi.size() + xj.size()) - shared;
+                    } else {
+                        // Walk the union of both rows' gap words.
+                        size_t p = 0, q = 0;
+                        while (p < gi.size() || q < gj.size()) {
+                            int w;
+                            if (q == gj.size() || (p < gi.size() && gi[p] < gj[q]))
+                                w = gi[p++];
+                            else if (p == gi.size() || gj[q] < gi[p])
+                                w = gj[q++];
+                            else {
+                                w = gi[p++];
+                                ++q;
+                            }
+                            const int x0 = w * 64;
+                            k.masked_f64(zi + x0, zj + x0, mi[w], mj[w], std::min(64, stride - x0), s);
+                            lost += __builtin_popcountll(~(mi[w] & mj[w]));
+                        }
+                    }
+                    // Padding bits are set, so they are never counted lost.
+                    const int n = nx - lost;
+                    if (n < 2) {
+                        result[i + (size_t)j * ny] = none;   // no pairwise-complete data
+                        continue;
+                    }
+
+                    const double sa  = sum[i] - s[0], sb  = sum[j] - s[1];
+                    const double saa = sq[i]  - s[2], sbb = sq[j]  - s[3];
+                    const double den = (n * saa - sa * sa) * (n * sbb - sb * sb);
+                    result[i + (size_t)j * ny] = (den > 0.0)
+                        ? clamp_r((n * ab - sa * sb) / std::sqrt(den)) : 0.0f;
+                }
+            }
+        }
+    }
+}
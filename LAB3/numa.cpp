@@ -0,0 +1,161 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  NUMA-AWARE MODE
+//
+//  Linux places a page on the node of the thread that first writes it, so
+//  NUMA locality comes down to two things: the threads must stay on their
+//  node (pinning), and every buffer must be first written by the threads
+//  that will later read it (first-touch).  No libnuma is needed for either;
+//  the node → CPU map is read from sysfs and threads are bound with
+//  sched_setaffinity.  The binding only lasts for one call: each team
+//  member saves its mask before pinning and puts it back on the way out,
+//  so the caller's threads (the master included) keep their affinity.
+// ─────────────────────────────────────────────────────────────────────────────
+
+namespace {
+struct Topology {
+    std::vector<std::vector<int> > cpus;   // per node with CPUs
+    std::vector<int>               node;   // per CPU id, -1 if unknown
+};
+}
+
+// "0-3,8,10-11" → {0, 1, 2, 3, 8, 10, 11}
+static std::vector<int> parse_list(const char* s)
+{
+    std::vector<int> out;
+    while (*s && *s != '\n') {
+        int lo = 0, hi = 0, used = 0;
+        if (std::sscanf(s, "%d-%d%n", &lo, &hi, &used) == 2) {
+            for (int c = lo; c <= hi; ++c)
+                out.push_back(c);
+        } else if (std::sscanf(s, "%d%n", &lo, &used) == 1) {
+            out.push_back(lo);
+        } else {
+            break;
+        }
+        s += used;
+        if (*s == ',')
+            ++s;
+    }
+    return out;
+}
+
+static bool read_line(const char* path, char* buf, int size)
+{
+    FILE* f = std::fopen(path, "r");
+    if (!f)
+        return false;
+    const bool ok = std::fgets(buf, size, f) != nullptr;
+    std::fclose(f);
+    return ok;
+}
+
+static Topology read_topology()
+{
+    Topology t;
+    char buf[4096], path[128];
+
+    if (read_line("/sys/devices/system/node/online", buf, sizeof buf)) {
+        const std::vector<int> nodes = parse_list(buf);
+        for (size_t n = 0; n < nodes.size(); ++n) {
+            std::snprintf(path, sizeof path, "/sys/devices/system/node/node%d/cpulist", nodes[n]);
+            if (!read_line(path, buf, sizeof buf))
+                continue;
+            std::vector<int> cpus = parse_list(buf);
+            if (!cpus.empty())   // skip memory-only nodes
+                t.cpus.push_back(cpus);
+        }
+    }
+    if (t.cpus.empty()) {   // no sysfs: one node holding every online CPU
+        t.cpus.resize(1);
+        for (int c = 0; c < (int)sysconf(_SC_NPROCESSORS_ONLN); ++c)
+            t.cpus[0].push_back(c);
+    }
+
+    for (size_t n = 0; n < t.cpus.size(); ++n)
+        for (size_t k = 0; k < t.cpus[n].size(); ++k) {
+            const int c = t.cpus[n][k];
+            if (c >= (int)t.node.size())
+                t.node.resize(c + 1, -1);
+            t.node[c] = (int)n;
+        }
+    return t;
+}
+
+static const Topology& topology()
+{
+    static const Topology t = read_topology();
+    return t;
+}
+
+int correlate_numa_nodes()
+{
+    return (int)topology().cpus.size();
+}
+
+int numa_current_node()
+{
+    const Topology& t = topology();
+    const int c = sched_getcpu();
+    return (c >= 0 && c < (int)t.node.size() && t.node[c] >= 0) ? t.node[c] : 0;
+}
+
+// The mask numa_pin_thread() replaced, for numa_unpin_thread().
+static thread_local cpu_set_t saved_mask;
+static thread_local bool      pinned = false;
+
+int numa_pin_thread()
+{
+    // An explicit OMP_PROC_BIND / OMP_PLACES binding wins over ours.
+    if (omp_get_proc_bind() != omp_proc_bind_false)
+        return numa_current_node();
+
+    const Topology& t = topology();
+    const int nodes = (int)t.cpus.size();
+    const int me    = omp_get_thread_num();
+    const int team  = omp_get_num_threads();
+
+    // Contiguous blocks of threads per node; within a node, CPUs in turn.
+    const int node  = (int)((long long)me * nodes / team);
+    int first = 0;
+    while ((long long)first * nodes / team < node)
+        ++first;
+    const std::vector<int>& cpus = t.cpus[node];
+    const int cpu = cpus[(me - first) % cpus.size()];
+
+    if (!pinned && sched_getaffinity(0, sizeof saved_mask, &saved_mask) != 0)
+        return numa_current_node();
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof set, &set) != 0)
+        return numa_current_node();
+    pinned = true;
+    return node;
+}
+
+void numa_unpin_thread()
+{
+    if (pinned && sched_setaffinity(0, sizeof saved_mask, &saved_mask) == 0)
+        pinned = false;
+}
+
+void correlate_first_touch(float* p, size_t rows, size_t cols)
+{
+#pragma omp parallel
+    {
+        numa_pin_thread();
+#pragma omp for schedule(static)
+        for (size_t r = 0; r < rows; ++r)
+            std::memset(p + r * cols, 0, cols * sizeof(float));
+        numa_unpin_thread();
+    }
+}
@@ -0,0 +1,151 @@
+#include "functions.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  COMPACT OUTPUT FORMATS
+//
+//  All three are sinks on top of correlate_streaming(), so the dense
+//  ny × ny matrix never exists: only one panel-pair block is live at a time
+//  and each block is folded into the target format as soon as it is done.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// ── Packed lower triangle ─────────────────────────────────────────────────────
+void correlate_packed(int ny, int nx, const float* data, float* packed,
+                      const StreamingOptions& opt)
+{
+    correlate_streaming(ny, nx, data, [&](const ResultTile& t) {
+        const bool diag = (t.i0 == t.j0);
+#pragma omp parallel for schedule(static)
+        for (int q = 0; q < t.nj; ++q) {
+            const int j = t.j0 + q;
+            for (int p = diag ? q : 0; p < t.ni; ++p) {
+                const int i = t.i0 + p;
+                packed[packed_index(i, j)] = t.r[p + (size_t)q * t.ni];
+            }
+        }
+    }, opt);
+}
+
+// ── Thresholded sparse (CSR of the strict lower triangle) ─────────────────────
+namespace {
+struct Entry {
+    int   i, j;
+    float r;
+    bool operator<(const Entry& o) const { return i != o.i ? i < o.i : j < o.j; }
+};
+}
+
+void correlate_threshold(int ny, int nx, const float* data, float threshold,
+                         SparseCorrelation& out, const StreamingOptions& opt)
+{
+    out.row_ptr.assign(1, 0);
+    out.col.clear();
+    out.val.clear();
+
+    // Per-thread hit lists for the current row panel.  Blocks arrive in
+    // order of increasing j0 and the diagonal block closes the panel, so the
+    // panel's rows can be sorted and appended to the CSR arrays right then.
+    std::vector<std::vector<Entry> > local(omp_get_max_threads());
+    std::vector<Entry> panel;
+
+    correlate_streaming(ny, nx, data, [&](const ResultTile& t) {
+        const bool diag = (t.i0 == t.j0);
+#pragma omp parallel
+        {
+            std::vector<Entry>& mine = local[omp_get_thread_num()];
+#pragma omp for schedule(static)
+            for (int q = 0; q < t.nj; ++q) {
+                for (int p = diag ? q + 1 : 0; p < t.ni; ++p) {
+                    const float r = t.r[p + (size_t)q * t.ni];
+                    if (std::fabs(r) > threshold) {
+                        Entry e = { t.i0 + p, t.j0 + q, r };
+                        mine.push_back(e);
+                    }
+                }
+            }
+        }
+        if (!diag)
+            return;
+
+        panel.clear();
+        for (size_t th = 0; th < local.size(); ++th) {
+            panel.insert(panel.end(), local[th].begin(), local[th].end());
+            local[th].clear();
+        }
+        std::sort(panel.begin(), panel.end());
+
+        size_t e = 0;
+        for (int i = t.i0; i < t.i0 + t.ni; ++i) {
+            for (; e < panel.size() && panel[e].i == i; ++e) {
+                out.col.push_back(panel[e].j);
+                out.val.push_back(panel[e].r);
+            }
+            out.row_ptr.push_back(out.col.size());
+        }
+    }, opt);
+}
+
+// ── Per-row top-k by |r| ──────────────────────────────────────────────────────
+namespace {
+struct Cand {
+    float r;
+    int   j;
+};
+// Min-heap on |r|: the weakest kept candidate sits at the front.
+inline bool stronger(const Cand& a, const Cand& b) { return std::fabs(a.r) > std::fabs(b.r); }
+}
+
+void correlate_topk(int ny, int nx, const float* data, int k, TopK& out,
+                    const StreamingOptions& opt)
+{
+    out.k = k;
+    out.index.assign((size_t)ny * k, -1);
+    out.value.assign((size_t)ny * k, 0.0f);
+    if (k <= 0)
+        return;
+
+    // One k-entry heap per row.  Every block is folded in twice — along its
+    // rows for heaps i, then along its columns for heaps j — and within each
+    // pass every heap is owned by exactly one thread, so no locking is needed.
+    std::vector<Cand> heap((size_t)ny * k);
+    std::vector<int>  size(ny, 0);
+
+    auto offer = [&](int row, int other, float r) {
+        Cand* h = &heap[(size_t)row * k];
+        Cand  c = { r, other };
+        if (size[row] < k) {
+            h[size[row]++] = c;
+            std::push_heap(h, h + size[row], stronger);
+        } else if (std::fabs(r) > std::fabs(h[0].r)) {
+            std::pop_heap(h, h + k, stronger);
+            h[k - 1] = c;
+            std::push_heap(h, h + k, stronger);
+        }
+    };
+
+    correlate_streaming(ny, nx, data, [&](const ResultTile& t) {
+        const bool diag = (t.i0 == t.j0);
+#pragma omp parallel for schedule(static)
+        for (int p = 0; p < t.ni; ++p)
+            for (int q = 0; q < (diag ? p : t.nj); ++q)
+                offer(t.i0 + p, t.j0 + q, t.r[p + (size_t)q * t.ni]);
+
+#pragma omp parallel for schedule(static)
+        for (int q = 0; q < t.nj; ++q)
+            for (int p = diag ? q + 1 : 0; p < t.ni; ++p)
+                offer(t.j0 + q, t.i0 + p, t.r[p + (size_t)q * t.ni]);
+    }, opt);
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < ny; ++i) {
+        Cand* h = &heap[(size_t)i * k];
+        std::sort_heap(h, h + size[i], stronger);   // strongest first
+        for (int e = 0; e < size[i]; ++e) {
+            out.index[(size_t)i * k + e] = h[e].j;
+            out.value[(size_t)i * k + e] = h[e].r;
+        }
+    }
+}
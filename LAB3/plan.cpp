@@ -0,0 +1,150 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  PLANS
+//
+//  Every correlate() call resolves Impl::Auto, looks up the kernel table,
+//  builds the tile list and allocates (and zero-fills) the normalised copy
+//  and the per-thread accumulators before doing any arithmetic.  On small
+//  and medium matrices that are correlated over and over, this set-up is a
+//  visible share of the run time.  A plan does the set-up once, in the
+//  manner of an FFTW plan:
+//
+//    create   resolve the impl, pick the tile or SYRK kernel, lay out the
+//             (I, J) tile schedule, allocate every scratch buffer and
+//             (blocked) first-touch it with the team that will use it
+//    execute  normalise into the plan's rows, then run the kernel
+//
+//  Creation zero-fills the padded rows with a static split; execute walks
+//  the same rows with the same split, normalising the ny real ones and
+//  re-zeroing the few padding rows past ny, so every thread rewrites the
+//  pages it first touched and nothing is allocated.  The SYRK workspace is
+//  only sized at creation; its first execute places the pages.
+// ─────────────────────────────────────────────────────────────────────────────
+
+struct CorrelatePlan {
+    int       ny, nx;
+    Impl      impl;
+    Precision precision;
+    int       threads;              // team size the accumulators are sized for
+
+    // Task 4: normalised rows (one of the two, by precision), the tile
+    // schedule and one TILE × TILE accumulator per thread.
+    int                    stride;
+    aligned_vector<double> norm64;
+    aligned_vector<float>  norm32;
+    std::vector<int>       tiles;   // (I, J) tile pairs, J <= I
+    aligned_vector<double> acc;
+    tile_f64_fn            tile64;
+    tile_f32_fn            tile32;
+
+    // Task 5.
+    SyrkWorkspace syrk;
+};
+
+template <class T>
+static void plan_rows(CorrelatePlan& p, aligned_vector<T>& norm)
+{
+    const int rows = (p.ny + TILE - 1) / TILE * TILE;
+    p.stride = padded_stride<T>(p.nx);
+    norm.resize((size_t)rows * p.stride);
+
+#pragma omp parallel for schedule(static) num_threads(p.threads)
+    for (int y = 0; y < rows; ++y)
+        std::fill(&norm[(size_t)y * p.stride], &norm[(size_t)(y + 1) * p.stride], T(0));
+}
+
+template <class T>
+static void run_blocked(CorrelatePlan& p, aligned_vector<T>& norm,
+                        void (*tile)(const T*, const T*, int, int, double*),
+                        const float* data, float* result)
+{
+    const int ny     = p.ny;
+    const int stride = p.stride;
+    const int rows   = (int)(norm.size() / stride);
+    const int ntiles = (int)p.tiles.size() / 2;
+
+#pragma omp parallel num_threads(p.threads)
+    {
+        double* acc = &p.acc[(size_t)omp_get_thread_num() * TILE * TILE];
+
+        // Same rows and static split as plan_rows(), so each thread
+        // rewrites the rows it first touched.
+#pragma omp for schedule(static)
+        for (int y = 0; y < rows; ++y) {
+            if (y < ny)
+                normalise_row(p.nx, data + (size_t)y * p.nx, &norm[(size_t)y * stride], stride);
+            else
+                std::fill(&norm[(size_t)y * stride], &norm[(size_t)(y + 1) * stride], T(0));
+        }
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < ntiles; ++t) {
+            run_tile(tile, norm.data(), stride, p.tiles[2 * t] * TILE,
+                     p.tiles[2 * t + 1] * TILE, acc, ny, result);
+        }
+    }
+}
+
+CorrelatePlan* correlate_plan_create(int ny, int nx, const CorrelateOptions& opt)
+{
+    if (ny <= 0 || nx <= 0)
+        return nullptr;
+
+    CorrelatePlan* p = new CorrelatePlan();
+    p->ny        = ny;
+    p->nx        = nx;
+    p->precision = opt.precision;
+    p->threads   = omp_get_max_threads();
+
+    Impl impl = opt.impl;
+    if (impl == Impl::Auto)
+        impl = correlate_auto_impl(ny, nx, p->threads);
+    p->impl = (impl == Impl::Syrk) ? Impl::Syrk : Impl::Blocked;
+
+    if (p->impl == Impl::Syrk) {
+        syrk_workspace_reserve(ny, nx, p->precision, p->syrk);
+        return p;
+    }
+
+    const KernelTable& k = select_kernels();
+    p->tile64 = k.tile_f64;
+    p->tile32 = (p->precision == Precision::Mixed) ? k.tile_f32_f64 : k.tile_f32;
+    if (p->precision == Precision::Double)
+        plan_rows(*p, p->norm64);
+    else
+        plan_rows(*p, p->norm32);
+
+    const int nt = (ny + TILE - 1) / TILE;
+    for (int bi = 0; bi < nt; ++bi)
+        for (int bj = 0; bj <= bi; ++bj) {
+            p->tiles.push_back(bi);
+            p->tiles.push_back(bj);
+        }
+    p->acc.resize((size_t)p->threads * TILE * TILE);
+    return p;
+}
+
+void correlate_plan_execute(CorrelatePlan* p, const float* data, float* result)
+{
+    if (p->impl == Impl::Syrk)
+        correlate_syrk(p->ny, p->nx, data, result, p->precision, p->syrk);
+    else if (p->precision == Precision::Double)
+        run_blocked(*p, p->norm64, p->tile64, data, result);
+    else
+        run_blocked(*p, p->norm32, p->tile32, data, result);
+}
+
+Impl correlate_plan_impl(const CorrelatePlan* p)
+{
+    return p->impl;
+}
+
+void correlate_plan_destroy(CorrelatePlan* p)
+{
+    delete p;
+}
@@ -0,0 +1,181 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  RANK CORRELATIONS
+//
+//  Spearman's ρ is Pearson's r of the ranks, so it only needs a ranking
+//  stage in front of correlate(): every row is argsorted (rows in
+//  parallel) and tied values share the mean of their positions.  The ranks
+//  are exact in float up to nx = 2²³, and the chosen Pearson kernel runs on
+//  them unchanged.
+//
+//  Kendall's τ_b compares the order of every pair of columns, O(nx²) per
+//  row pair by definition.  Knight's algorithm does it in O(nx log nx):
+//  sort the columns by row i (ties broken by row j), then the discordant
+//  pairs are exactly the swaps a stable merge sort makes when sorting the
+//  row j values of that order:
+//
+//    τ_b = (n0 - n1 - n2 + n3 - 2·swaps) / √((n0 - n1)(n0 - n2))
+//
+//  n0 = nx(nx - 1)/2, n1 / n2 the pairs tied in row i / row j, n3 those
+//  tied in both.  Rows are replaced by dense integer ranks up front, so the
+//  per-pair work compares ints and ties are exact; the argsort of row i is
+//  also shared by all of its pairs.  Pairs are spread over the team with
+//  the triangle scheduler of Tasks 2 and 3.
+// ─────────────────────────────────────────────────────────────────────────────
+
+// idx = 0..nx-1 ordered by row value (stable, so ties keep column order).
+static void argsort(int nx, const float* row, std::vector<int>& idx)
+{
+    idx.resize(nx);
+    for (int x = 0; x < nx; ++x)
+        idx[x] = x;
+    std::stable_sort(idx.begin(), idx.end(), [row](int a, int b) { return row[a] < row[b]; });
+}
+
+void rank_rows(int ny, int nx, const float* data, float* ranks)
+{
+#pragma omp parallel
+    {
+        std::vector<int> idx;
+
+#pragma omp for schedule(dynamic, 16)
+        for (int y = 0; y < ny; ++y) {
+            const float* row = data  + (size_t)y * nx;
+            float*       out = ranks + (size_t)y * nx;
+            argsort(nx, row, idx);
+            for (int a = 0, b; a < nx; a = b) {
+                for (b = a + 1; b < nx && row[idx[b]] == row[idx[a]]; ++b) {}
+                const float r = 0.5f * (a + b + 1);   // mean of ranks a+1 .. b
+                for (int k = a; k < b; ++k)
+                    out[idx[k]] = r;
+            }
+        }
+    }
+}
+
+void correlate_spearman(int ny, int nx, const float* data, float* result,
+                        const CorrelateOptions& opt)
+{
+    aligned_vector<float> ranks((size_t)ny * nx);
+    rank_rows(ny, nx, data, ranks.data());
+    correlate(ny, nx, ranks.data(), result, opt);
+}
+
+// Pairs of equal values in a sorted run: Σ t(t - 1)/2 over runs of length t.
+static long long tied_pairs(const int* v, int n)
+{
+    long long t = 0;
+    for (int a = 0, b; a < n; a = b) {
+        for (b = a + 1; b < n && v[b] == v[a]; ++b) {}
+        t += (long long)(b - a) * (b - a - 1) / 2;
+    }
+    return t;
+}
+
+static const int KENDALL_RUN = 16;   // insertion-sorted before merging
+
+// Sort v[0, n) ascending (stable) and return how many pairs were out of
+// order: the number of a < b with v[a] > v[b].  Runs of KENDALL_RUN are
+// insertion-sorted, counting each shift; then bottom-up merges.
+static long long merge_swaps(int* v, int* tmp, int n)
+{
+    long long swaps = 0;
+    for (int lo = 0; lo < n; lo += KENDALL_RUN) {
+        const int hi = std::min(lo + KENDALL_RUN, n);
+        for (int k = lo + 1; k < hi; ++k) {
+            const int x = v[k];
+            int m = k;
+            for (; m > lo && v[m - 1] > x; --m)
+                v[m] = v[m - 1];
+            v[m] = x;
+            swaps += k - m;
+        }
+    }
+    for (int w = KENDALL_RUN; w < n; w *= 2) {
+        for (int lo = 0; lo < n; lo += 2 * w) {
+            const int mid = std::min(lo + w, n), hi = std::min(lo + 2 * w, n);
+            int a = lo, b = mid, k = lo;
+            while (a < mid && b < hi) {
+                if (v[b] < v[a]) {
+                    swaps += mid - a;   // v[b] overtakes the rest of the left run
+                    tmp[k++] = v[b++];
+                } else {
+                    tmp[k++] = v[a++];
+                }
+            }
+            while (a < mid) tmp[k++] = v[a++];
+            while (b < hi)  tmp[k++] = v[b++];
+        }
+        std::swap(v, tmp);   // the caller only needs the count, not which buffer
+    }
+    return swaps;
+}
+
+void correlate_kendall(int ny, int nx, const float* data, float* result)
+{
+    // Dense integer ranks (ties equal), each row's argsort, its tied pairs.
+    std::vector<int>       rank((size_t)ny * nx), order((size_t)ny * nx);
+    std::vector<long long> ties(ny);
+#pragma omp parallel
+    {
+        std::vector<int> idx;
+
+#pragma omp for schedule(dynamic, 16)
+        for (int y = 0; y < ny; ++y) {
+            const float* row = data + (size_t)y * nx;
+            int* r = &rank[(size_t)y * nx];
+            argsort(nx, row, idx);
+            int d = 0;
+            for (int k = 0; k < nx; ++k) {
+                if (k > 0 && row[idx[k]] != row[idx[k - 1]])
+                    ++d;
+                r[idx[k]] = d;
+            }
+            int* o = &order[(size_t)y * nx];
+            std::copy(idx.begin(), idx.end(), o);
+            for (int k = 0; k < nx; ++k)
+                idx[k] = r[o[k]];   // the ranks in sorted order
+            ties[y] = tied_pairs(idx.data(), nx);
+        }
+    }
+
+    const double n0 = 0.5 * nx * (nx - 1.0);
+
+    for_each_pair_tile(ny, Schedule::Triangle, [&](const TriTile& t) {
+        std::vector<int> v(nx), tmp(nx);
+        for (int i = t.i0; i < t.i1; ++i) {
+            const int* oi = &order[(size_t)i * nx];
+            const int* ri = &rank[(size_t)i * nx];
+            const int jend = std::min(t.j1, i + 1);
+            for (int j = t.j0; j < jend; ++j) {
+                const int* rj = &rank[(size_t)j * nx];
+
+                // Row j's ranks in row i's order; within each run tied in
+                // row i, sorted by row j, which also exposes the joint ties.
+                for (int k = 0; k < nx; ++k)
+                    v[k] = rj[oi[k]];
+                long long joint = 0;
+                for (int a = 0, b; ties[i] > 0 && a < nx; a = b) {
+                    for (b = a + 1; b < nx && ri[oi[b]] == ri[oi[a]]; ++b) {}
+                    if (b - a > 1) {
+                        std::sort(&v[a], &v[a] + (b - a));
+                        joint += tied_pairs(&v[a], b - a);
+                    }
+                }
+
+                const long long swaps = merge_swaps(v.data(), tmp.data(), nx);
+                const double n1 = (double)ties[i], n2 = (double)ties[j];
+                const double den = std::sqrt((n0 - n1) * (n0 - n2));
+                const double tau = (den > 0.0)
+                    ? (n0 - n1 - n2 + (double)joint - 2.0 * (double)swaps) / den : 0.0;
+                result[i + (size_t)j * ny] = clamp_r(tau);
+            }
+        }
+    }, nullptr);
+}
@@ -0,0 +1,199 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <omp.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  TRIANGULAR SCHEDULER (Tasks 2 and 3)
+//
+//  Row i of the lower triangle holds i + 1 pairs, so schedule(dynamic, 16)
+//  over i leaves the heaviest chunks for last, and every chunk is claimed
+//  through one shared counter.  Instead, the triangle is cut up front into
+//  2D tiles of (nearly) equal pair count:
+//
+//    - rows are split into bands of about √W rows, W the target tile work;
+//    - each band is cut along j wherever the running pair count reaches W,
+//      so tiles crossing the diagonal come out wider than the ones left of
+//      it but hold the same number of pairs.
+//
+//  The tiles, in band order, are then dealt out as contiguous runs of equal
+//  total work, one run per thread, forming that thread's deque.  A thread
+//  pops from the front of its own deque (neighbouring tiles, warm rows) and,
+//  once it is empty, steals single tiles from the back of the others'.  The
+//  deque locks are per thread, so they only see contention while stealing.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static const int TILES_PER_THREAD = 16;   // initial share, leaves room to steal
+
+// Pairs j <= i with i in [i0, i1) and j in [j0, j1).
+static double tile_work(const TriTile& t)
+{
+    double w = 0;
+    for (int i = t.i0; i < t.i1; ++i)
+        w += std::max(0, std::min(t.j1, i + 1) - t.j0);
+    return w;
+}
+
+static void make_tiles(int n, int threads, std::vector<TriTile>& tiles)
+{
+    const double total  = 0.5 * n * (n + 1.0);
+    const double target = std::max(1.0, total / ((double)threads * TILES_PER_THREAD));
+    const int    band   = std::max(1, std::min(n, (int)std::sqrt(target)));
+
+    for (int i0 = 0; i0 < n; i0 += band) {
+        const int i1 = std::min(n, i0 + band);
+        double acc = 0;
+        int    j0  = 0;
+        for (int j = 0; j < i1; ++j) {
+            acc += i1 - std::max(i0, j);   // rows of the band with i >= j
+            if (acc >= target || j == i1 - 1) {
+                TriTile t = { i0, i1, j0, j + 1 };
+                tiles.push_back(t);
+                j0  = j + 1;
+                acc = 0;
+            }
+        }
+    }
+}
+
+namespace {
+// Tiles [head, tail) of the shared tile list.  Padded so that neighbouring
+// deques' locks and indices never share a cache line.
+struct Deque {
+    omp_lock_t lock;
+    int        head, tail;
+    char       pad[64];
+};
+}
+
+static bool pop_front(Deque& d, int& t)
+{
+    omp_set_lock(&d.lock);
+    const bool ok = d.head < d.tail;
+    if (ok)
+        t = d.head++;
+    omp_unset_lock(&d.lock);
+    return ok;
+}
+
+static bool steal_back(Deque& d, int& t)
+{
+    omp_set_lock(&d.lock);
+    const bool ok = d.head < d.tail;
+    if (ok)
+        t = --d.tail;
+    omp_unset_lock(&d.lock);
+    return ok;
+}
+
+static void run_triangle(int n, const std::function<void(const TriTile&)>& body,
+                         LoadStats* load)
+{
+    const int threads = omp_get_max_threads();
+
+    std::vector<TriTile> tiles;
+    make_tiles(n, threads, tiles);
+    const int ntiles = (int)tiles.size();
+
+    // Deal contiguous runs of equal work: a tile belongs to the thread whose
+    // share of the total contains the tile's midpoint.
+    std::vector<Deque> deque(threads);
+    const double total = 0.5 * n * (n + 1.0);
+    double done = 0;
+    int    t    = 0;
+    for (int th = 0; th < threads; ++th) {
+        omp_init_lock(&deque[th].lock);
+        deque[th].head = t;
+        while (t < ntiles) {
+            const double w = tile_work(tiles[t]);
+            if ((done + 0.5 * w) * threads >= (th + 1) * total && th + 1 < threads)
+                break;
+            done += w;
+            ++t;
+        }
+        deque[th].tail = t;
+    }
+
+    const double start = omp_get_wtime();
+#pragma omp parallel num_threads(threads)
+    {
+        const int    me = omp_get_thread_num();
+        const double t0 = omp_get_wtime();
+        int items = 0, stolen = 0, k;
+
+        while (pop_front(deque[me], k)) {
+            body(tiles[k]);
+            ++items;
+        }
+        // No tile is ever added, so one sweep that finds every deque empty
+        // means the whole triangle has been handed out.
+        for (int v = 1; v < threads; ++v) {
+            Deque& victim = deque[(me + v) % threads];
+            while (steal_back(victim, k)) {
+                body(tiles[k]);
+                ++items;
+                ++stolen;
+            }
+        }
+
+        if (load) {
+            load->active[me] = omp_get_wtime() - t0;
+            load->items[me]  = items;
+            load->stolen[me] = stolen;
+            load->node[me]   = numa_current_node();
+        }
+    }
+    if (load)
+        load->wall = omp_get_wtime() - start;
+
+    for (int th = 0; th < threads; ++th)
+        omp_destroy_lock(&deque[th].lock);
+}
+
+static void run_dynamic(int n, const std::function<void(const TriTile&)>& body,
+                        LoadStats* load)
+{
+    const double start = omp_get_wtime();
+#pragma omp parallel
+    {
+        const int    me = omp_get_thread_num();
+        const double t0 = omp_get_wtime();
+        int items = 0;
+
+#pragma omp for schedule(dynamic, 16) nowait
+        for (int i = 0; i < n; ++i) {
+            TriTile row = { i, i + 1, 0, i + 1 };
+            body(row);
+            ++items;
+        }
+
+        if (load) {
+            load->active[me] = omp_get_wtime() - t0;
+            load->items[me]  = items;
+            load->node[me]   = numa_current_node();
+        }
+    }
+    if (load)
+        load->wall = omp_get_wtime() - start;
+}
+
+void for_each_pair_tile(int n, Schedule schedule,
+                        const std::function<void(const TriTile&)>& body,
+                        LoadStats* load)
+{
+    if (load) {
+        const int threads = omp_get_max_threads();
+        load->wall = 0.0;
+        load->active.assign(threads, 0.0);
+        load->items.assign(threads, 0);
+        load->stolen.assign(threads, 0);
+        load->node.assign(threads, 0);
+        load->bytes.assign(threads, 0.0);
+    }
+    if (schedule == Schedule::Dynamic)
+        run_dynamic(n, body, load);
+    else
+        run_triangle(n, body, load);
+}
@@ -0,0 +1,220 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <omp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  OUT-OF-CORE CORRELATION
+//
+//  The rows are processed in panels of P rows.  For every panel pair
+//  (I, J <= I) both panels are normalised into scratch buffers, the P × P
+//  block of the triangle is computed with the Task 4 tile kernels, and the
+//  finished block is handed to a sink.  Nothing of size ny × nx or ny × ny is
+//  ever allocated; P is the largest multiple of TILE whose working set fits
+//  the memory budget.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static int round_up(int n, int m) { return (n + m - 1) / m * m; }
+
+// Bytes needed for a panel height of p rows: two normalised panels, one
+// result block and a TILE × TILE accumulator per thread.
+template <class T>
+static size_t working_set(int p, int stride, int threads)
+{
+    return 2 * (size_t)p * stride * sizeof(T)
+         + (size_t)p * p * sizeof(float)
+         + (size_t)threads * TILE * TILE * sizeof(double);
+}
+
+template <class T>
+static int panel_rows(int ny, int stride, size_t budget, int threads)
+{
+    const int full = round_up(ny, TILE);
+    int p = TILE;   // never less than one tile, even if over budget
+    while (p < full && working_set<T>(p + TILE, stride, threads) <= budget)
+        p += TILE;
+    return p;
+}
+
+/**
+ * block[(i) + (j) * ni] = r(a row i, b row j) for one panel pair, computed
+ * tile by tile across the thread team.  `a` and `b` are normalised panels
+ * padded to whole tiles; on a diagonal pair a == b and only j <= i is set.
+ */
+template <class T>
+static void panel_block(const T* a, const T* b, int ni, int nj, int stride,
+                        bool diag, float* block,
+                        void (*tile)(const T*, const T*, int, int, double*))
+{
+    const int ti = (ni + TILE - 1) / TILE;
+    const int tj = (nj + TILE - 1) / TILE;
+
+    std::vector<int> tiles;
+    for (int bi = 0; bi < ti; ++bi)
+        for (int bj = 0; bj < (diag ? bi + 1 : tj); ++bj) {
+            tiles.push_back(bi);
+            tiles.push_back(bj);
+        }
+    const int ntiles = (int)tiles.size() / 2;
+
+#pragma omp parallel
+    {
+        std::vector<double> acc(TILE * TILE);
+
+#pragma omp for schedule(dynamic, 1)
+        for (int t = 0; t < ntiles; ++t) {
+            const int i0 = tiles[2 * t] * TILE;
+            const int j0 = tiles[2 * t + 1] * TILE;
+            const bool on_diag = diag && (i0 == j0);
+            tile(a + (size_t)i0 * stride, b + (size_t)j0 * stride,
+                 stride, on_diag, acc.data());
+
+            const int iend = std::min(i0 + TILE, ni);
+            for (int i = i0; i < iend; ++i) {
+                const int jend = on_diag ? i + 1 : std::min(j0 + TILE, nj);
+                for (int j = j0; j < jend; ++j)
+                    block[i + (size_t)j * ni] = clamp_r(acc[(i - i0) * TILE + (j - j0)]);
+            }
+        }
+    }
+}
+
+template <class T>
+static void streaming_impl(int ny, int nx, const float* data,
+                           const TileSink& sink, size_t budget,
+                           void (*tile)(const T*, const T*, int, int, double*))
+{
+    const int stride = padded_stride<T>(nx);
+    const int P      = panel_rows<T>(ny, stride, budget, omp_get_max_threads());
+    const int np     = (ny + P - 1) / P;
+
+    // Reshaped per panel, allocated once at the first (largest) one.
+    AlignedMatrix<T>   pi, pj;
+    std::vector<float> block((size_t)P * P);
+
+    for (int bi = 0; bi < np; ++bi) {
+        const int i0 = bi * P;
+        const int ni = std::min(P, ny - i0);
+        normalise_rows(ni, nx, data + (size_t)i0 * nx, pi, round_up(ni, TILE));
+
+        for (int bj = 0; bj <= bi; ++bj) {
+            const int  j0   = bj * P;
+            const int  nj   = std::min(P, ny - j0);
+            const bool diag = (bi == bj);
+            if (!diag)
+                normalise_rows(nj, nx, data + (size_t)j0 * nx, pj, round_up(nj, TILE));
+
+            panel_block(pi.data(), diag ? pi.data() : pj.data(), ni, nj, stride,
+                        diag, block.data(), tile);
+
+            ResultTile t;
+            t.i0 = i0;  t.j0 = j0;
+            t.ni = ni;  t.nj = nj;
+            t.r  = block.data();
+            sink(t);
+        }
+    }
+}
+
+void correlate_streaming(int ny, int nx, const float* data,
+                         const TileSink& sink, const StreamingOptions& opt)
+{
+    const KernelTable& k = select_kernels();
+    switch (opt.precision) {
+    case Precision::Float:
+        streaming_impl<float>(ny, nx, data, sink, opt.memory_budget, k.tile_f32);
+        break;
+    case Precision::Mixed:
+        streaming_impl<float>(ny, nx, data, sink, opt.memory_budget, k.tile_f32_f64);
+        break;
+    case Precision::Double:
+    default:
+        streaming_impl<double>(ny, nx, data, sink, opt.memory_budget, k.tile_f64);
+        break;
+    }
+}
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  FILE DRIVER
+//  Input is mmapped, so panels are paged in on demand and the page cache,
+//  not the heap, holds them.  Each finished block is written with pwrite at
+//  its place in the dense ny × ny output; cells above the diagonal are never
+//  written and stay as holes in the (sparse) file.
+// ─────────────────────────────────────────────────────────────────────────────
+
+static bool write_at(int fd, const float* src, size_t count, off_t offset)
+{
+    const char* p = (const char*)src;
+    size_t left = count * sizeof(float);
+    while (left > 0) {
+        ssize_t n = pwrite(fd, p, left, offset);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p      += n;
+        left   -= (size_t)n;
+        offset += n;
+    }
+    return true;
+}
+
+bool correlate_file(const char* input_path, int ny, int nx,
+                    const char* output_path, const StreamingOptions& opt)
+{
+    const size_t in_bytes  = (size_t)ny * nx * sizeof(float);
+    const size_t out_bytes = (size_t)ny * ny * sizeof(float);
+
+    int in = open(input_path, O_RDONLY);
+    if (in < 0) {
+        std::fprintf(stderr, "correlate: cannot open %s: %s\n", input_path, std::strerror(errno));
+        return false;
+    }
+    struct stat st;
+    if (fstat(in, &st) != 0 || (size_t)st.st_size < in_bytes) {
+        std::fprintf(stderr, "correlate: %s is smaller than %d x %d floats\n", input_path, ny, nx);
+        close(in);
+        return false;
+    }
+    void* map = mmap(nullptr, in_bytes, PROT_READ, MAP_SHARED, in, 0);
+    close(in);
+    if (map == MAP_FAILED) {
+        std::fprintf(stderr, "correlate: cannot mmap %s: %s\n", input_path, std::strerror(errno));
+        return false;
+    }
+
+    int out = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (out < 0 || ftruncate(out, (off_t)out_bytes) != 0) {
+        std::fprintf(stderr, "correlate: cannot create %s: %s\n", output_path, std::strerror(errno));
+        if (out >= 0)
+            close(out);
+        munmap(map, in_bytes);
+        return false;
+    }
+
+    bool ok = true;
+    correlate_streaming(ny, nx, (const float*)map, [&](const ResultTile& t) {
+        // Column j of the block is contiguous in i, as in the dense layout.
+        for (int q = 0; q < t.nj && ok; ++q) {
+            const int first = (t.i0 == t.j0) ? q : 0;   // only i >= j
+            const off_t off = (off_t)(((size_t)(t.j0 + q) * ny + t.i0 + first) * sizeof(float));
+            ok = write_at(out, t.r + first + (size_t)q * t.ni, t.ni - first, off);
+        }
+    }, opt);
+
+    if (!ok)
+        std::fprintf(stderr, "correlate: write to %s failed: %s\n", output_path, std::strerror(errno));
+    if (close(out) != 0)
+        ok = false;
+    munmap(map, in_bytes);
+    return ok;
+}
@@ -0,0 +1,285 @@
+#include "functions.h"
+#include "functions_internal.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <omp.h>
+#ifdef USE_CBLAS
+#include <cblas.h>
+#endif
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  TASK 5 — GEMM formulation: normalise, then SYRK
+//
+//  With N the matrix of normalised rows, the correlation matrix is N·Nᵀ, a
+//  symmetric rank-nx update of which only the lower triangle is needed.
+//  The built-in SYRK follows the Goto / BLIS layering:
+//
+//    jc  NC columns of C (rows j of N)     B panel  N[jc, :]  → shared
+//     ic  MC rows of C (i ≥ jc only)       C block            → per-thread
+//      pc  KC-deep slice of x              A block  N[ic, pc] → ~L2
+//       jr  NR columns   ┐ macro-kernel
+//        ir  MR rows     ┘ → micro-kernel on an MR × NR register tile
+//
+//  Packing copies each block once into k-major micro-panels, so the
+//  micro-kernel (kernels_impl.h) streams both operands contiguously however
+//  long the rows are.  The normalisation stage already writes the rows as
+//  MR-wide micro-panels over the full depth, so every A block is used in
+//  place and only the shared B panel is repacked (NR wide), over the whole
+//  depth at once; NC shrinks as rows grow to keep that panel in L3.  The
+//  ic blocks of one jc step are spread over the thread team, and each
+//  thread sums the k-slices of its C block in the compute precision,
+//  rounding to float once, at the clamp.  Building with USE_BLAS=1 swaps
+//  all of this for the system BLAS ?syrk.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#ifndef USE_CBLAS
+
+static const int SYRK_KC = 256;    // k-depth of a packed panel
+static const int SYRK_MC = 120;    // target rows per A block (rounded to MR)
+static const int SYRK_NC = 2048;   // most columns per B panel (rounded to NR)
+static const int SYRK_MAX_TILE = 48 * 8;   // largest MR × NR in kernels_impl.h
+static const size_t SYRK_PANEL = (size_t)4 << 20;   // B panel elements, ~L3
+
+/**
+ * Pack rows [r0, r0 + rows) × x-range [k0, k0 + kc) of the MR-packed
+ * operand `a` (depth nx, see normalise_rows_packed) into ceil(rows / w)
+ * micro-panels of width w:
+ *   dst[(p * kc + k) * w + m] = row r0 + p * w + m, column k0 + k
+ * Rows at or beyond ny are packed as zeros, so edge tiles need no special
+ * case in the micro-kernel.
+ */
+template <class C>
+static void pack_panel(const C* a, int MR, int nx, int ny, int r0, int rows,
+                       int k0, int kc, int w, C* dst)
+{
+    for (int p = 0; p * w < rows; ++p) {
+        C* d = dst + (size_t)p * kc * w;
+        for (int m = 0; m < w; ++m) {
+            const int r = r0 + p * w + m;
+            if (r < ny && p * w + m < rows) {
+                const C* src = a + (size_t)(r / MR) * MR * nx + (size_t)k0 * MR + r % MR;
+                for (int k = 0; k < kc; ++k)
+                    d[k * w + m] = src[(size_t)k * MR];
+            } else {
+                for (int k = 0; k < kc; ++k)
+                    d[k * w + m] = C(0);
+            }
+        }
+    }
+}
+
+// Columns per B panel: the panel is packed over the full depth nx, so it
+// narrows for long rows to stay within SYRK_PANEL elements.
+static int panel_cols(int nx, int NR)
+{
+    const int widest = (SYRK_NC + NR - 1) / NR * NR;
+    const int fit    = (int)std::min<size_t>(SYRK_PANEL / nx, widest);
+    return std::max(NR, fit / NR * NR);
+}
+
+// Size of the shared B panel buffer.
+static size_t bpack_size(int nx, int NR)
+{
+    return (size_t)panel_cols(nx, NR) * nx;
+}
+
+// Size of one thread's C block: MC rows by the widest panel that ny fills.
+static size_t cblock_size(int ny, int nx, int MR, int NR)
+{
+    const int MC = (SYRK_MC + MR - 1) / MR * MR;
+    return (size_t)MC * std::min(panel_cols(nx, NR), (ny + NR - 1) / NR * NR);
+}
+
+// `bpack` holds bpack_size(nx, NR) elements, `cblocks` one
+// cblock_size(ny, nx, MR, NR) block per thread of the team.
+template <class C>
+static void syrk_lower(int ny, int nx, const C* a, float* result,
+                       int MR, int NR, void (*micro)(int, const C*, const C*, C*),
+                       C* bpack, C* cblocks)
+{
+    const int MC = (SYRK_MC + MR - 1) / MR * MR;
+    const int NC = panel_cols(nx, NR);
+
+#pragma omp parallel
+    {
+        C cbuf[SYRK_MAX_TILE];
+        // This thread's block of C, as MR × NR tiles in (jr, ir) order.
+        C* cblk = cblocks + (size_t)omp_get_thread_num() * cblock_size(ny, nx, MR, NR);
+
+        for (int jc = 0; jc < ny; jc += NC) {
+            const int nc = std::min(NC, ny - jc);
+            const int np = (nc + NR - 1) / NR;
+
+            // Pack the shared B panel, one NR micro-panel per iteration; the
+            // k-slice at pc starts at bpack + pc * np * NR.
+#pragma omp for schedule(static)
+            for (int p = 0; p < np; ++p)
+                for (int pc = 0; pc < nx; pc += SYRK_KC) {
+                    const int kc = std::min(SYRK_KC, nx - pc);
+                    pack_panel(a, MR, nx, ny, jc + p * NR, std::min(NR, nc - p * NR),
+                               pc, kc, NR, bpack + (size_t)pc * np * NR + (size_t)p * NR * kc);
+                }
+
+            // Only A blocks that reach the lower triangle (i >= jc).
+            const int ic0 = jc / MC * MC;
+#pragma omp for schedule(dynamic, 1)
+            for (int ic = ic0; ic < ny; ic += MC) {
+                const int mc = std::min(MC, ny - ic);
+                const int mt = (mc + MR - 1) / MR;
+
+                for (int pc = 0; pc < nx; pc += SYRK_KC) {
+                    const int kc = std::min(SYRK_KC, nx - pc);
+                    const C*  bp = bpack + (size_t)pc * np * NR;
+
+                    // Macro-kernel: the B micro-panel stays in L1 across ir.
+                    for (int jr = 0; jr < nc; jr += NR) {
+                        const int j = jc + jr;
+                        for (int ir = 0; ir < mc; ir += MR) {
+                            const int i = ic + ir;
+                            if (i + MR - 1 < j)
+                                continue;   // tile entirely above diagonal
+                            C* acc = cblk + ((size_t)(jr / NR) * mt + ir / MR) * MR * NR;
+                            micro(kc, a + (size_t)i * nx + (size_t)pc * MR,
+                                  bp + (size_t)jr * kc, pc == 0 ? acc : cbuf);
+                            if (pc > 0)
+                                for (int t = 0; t < MR * NR; ++t)
+                                    acc[t] += cbuf[t];
+                        }
+                    }
+                }
+
+                // Every k-slice is in: clamp and round to float once.
+                for (int jr = 0; jr < nc; jr += NR) {
+                    const int j = jc + jr;
+                    for (int ir = 0; ir < mc; ir += MR) {
+                        const int i = ic + ir;
+                        if (i + MR - 1 < j)
+                            continue;
+                        const C*  acc  = cblk + ((size_t)(jr / NR) * mt + ir / MR) * MR * NR;
+                        const int nmax = std::min(NR, jc + nc - j);
+                        const int mmax = std::min(MR, ny - i);
+                        for (int n = 0; n < nmax; ++n) {
+                            float* col = result + (size_t)(j + n) * ny;
+                            for (int m = std::max(0, j + n - i); m < mmax; ++m)
+                                col[i + m] = clamp_r(acc[n * MR + m]);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+#else // USE_CBLAS
+
+// result[i + j*ny] for j <= i is row j, column i of a row-major ny × ny
+// matrix: the upper triangle in BLAS terms.
+static void syrk_cblas(int ny, int nx, const double* norm, int stride, float* result,
+                       aligned_vector<double>& c)
+{
+    if (c.size() != (size_t)ny * ny)
+        c.resize((size_t)ny * ny);
+    cblas_dsyrk(CblasRowMajor, CblasUpper, CblasNoTrans, ny, nx,
+                1.0, norm, stride, 0.0, c.data(), ny);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int j = 0; j < ny; ++j)
+        for (int i = j; i < ny; ++i)
+            result[i + (size_t)j * ny] = clamp_r(c[i + (size_t)j * ny]);
+}
+
+static void syrk_cblas(int ny, int nx, const float* norm, int stride, float* result,
+                       aligned_vector<float>&)
+{
+    cblas_ssyrk(CblasRowMajor, CblasUpper, CblasNoTrans, ny, nx,
+                1.0f, norm, stride, 0.0f, result, ny);
+#pragma omp parallel for schedule(dynamic, 16)
+    for (int j = 0; j < ny; ++j)
+        for (int i = j; i < ny; ++i)
+            result[i + (size_t)j * ny] = clamp_r(result[i + (size_t)j * ny]);
+}
+
+#endif // USE_CBLAS
+
+/**
+ * Size every buffer of `ws` for correlate_syrk(ny, nx, ..., prec, ws)
+ * without running it: the normalised operand (packed into MR panels, or
+ * padded rows for BLAS), the B panel and one C block per thread of
+ * omp_get_max_threads() (or the BLAS double result).  The pages are left
+ * untouched, so the run that first fills them places them.
+ */
+void syrk_workspace_reserve(int ny, int nx, Precision prec, SyrkWorkspace& ws)
+{
+#ifdef USE_CBLAS
+    if (prec == Precision::Double) {
+        ws.a64.resize((size_t)ny * padded_stride<double>(nx));
+        ws.b64.resize((size_t)ny * ny);
+    } else {
+        ws.a32.resize((size_t)ny * padded_stride<float>(nx));
+    }
+#else
+    const KernelTable& k = select_kernels();
+    const int threads = omp_get_max_threads();
+    if (prec == Precision::Float) {
+        const int w = k.syrk_mr_f32;
+        ws.a32.resize((size_t)((ny + w - 1) / w) * w * nx);
+        ws.b32.resize(bpack_size(nx, k.syrk_nr_f32));
+        ws.c32.resize(threads * cblock_size(ny, nx, w, k.syrk_nr_f32));
+    } else {
+        const int w = k.syrk_mr_f64;
+        ws.a64.resize((size_t)((ny + w - 1) / w) * w * nx);
+        ws.b64.resize(bpack_size(nx, k.syrk_nr_f64));
+        ws.c64.resize(threads * cblock_size(ny, nx, w, k.syrk_nr_f64));
+    }
+#endif
+}
+
+void correlate_syrk(int ny, int nx, const float* data, float* result, Precision prec,
+                    SyrkWorkspace& ws)
+{
+    syrk_workspace_reserve(ny, nx, prec, ws);
+#ifdef USE_CBLAS
+    // BLAS takes plain row-major operands.  It has no mixed SYRK, so Mixed
+    // runs as Float there.
+    if (prec == Precision::Double) {
+        const int stride = padded_stride<double>(nx);
+        normalise_rows(ny, nx, data, MatrixView<double>(ws.a64.data(), ny, nx, stride));
+        syrk_cblas(ny, nx, ws.a64.data(), stride, result, ws.b64);
+    } else {
+        const int stride = padded_stride<float>(nx);
+        normalise_rows(ny, nx, data, MatrixView<float>(ws.a32.data(), ny, nx, stride));
+        syrk_cblas(ny, nx, ws.a32.data(), stride, result, ws.b32);
+    }
+#else
+    const KernelTable& k = select_kernels();
+
+    // Mixed stores float-rounded rows, already widened to double.
+    if (prec == Precision::Float) {
+        normalise_rows_packed<float, float>(ny, nx, data, ws.a32, k.syrk_mr_f32);
+        syrk_lower(ny, nx, ws.a32.data(), result, k.syrk_mr_f32, k.syrk_nr_f32, k.syrk_f32,
+                   ws.b32.data(), ws.c32.data());
+    } else {
+        if (prec == Precision::Mixed)
+            normalise_rows_packed<float, double>(ny, nx, data, ws.a64, k.syrk_mr_f64);
+        else
+            normalise_rows_packed<double, double>(ny, nx, data, ws.a64, k.syrk_mr_f64);
+        syrk_lower(ny, nx, ws.a64.data(), result, k.syrk_mr_f64, k.syrk_nr_f64, k.syrk_f64,
+                   ws.b64.data(), ws.c64.data());
+    }
+#endif
+}
+
+void correlate_syrk(int ny, int nx, const float* data, float* result, Precision prec)
+{
+    SyrkWorkspace ws;
+    correlate_syrk(ny, nx, data, result, prec, ws);
+}
+
+const char* correlate_syrk_backend()
+{
+#ifdef USE_CBLAS
+    return "cblas";
+#else
+    return "built-in";
+#endif
+}
@@ -0,0 +1,174 @@
+#ifndef COMMON_MATRIX_H
+#define COMMON_MATRIX_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  matrix.h  –  flat, aligned, row-major matrix shared by the LAB programs
+//
+//  One allocation per matrix (no vector<vector>, no row pointers to chase),
+//  rows `stride` elements apart with the stride padded to a whole
+//  MATRIX_ALIGN bytes by default, so every row starts on a cache line and
+//  SIMD kernels can run over the padding instead of a tail.
+//
+//  Matrix<T> owns its storage and is move-only: a copy of a few hundred MB
+//  should never happen by accident.  MatrixView<T> is the non-owning
+//  (pointer, rows, cols, stride) form: a whole matrix, a block of one, or
+//  memory owned by someone else, passed by value and never copied from.
+//
+//  Elements are left uninitialised on allocation, as with malloc, so the
+//  thread that first writes a page also places it (first touch); call
+//  fill() where zeros matter.  The Storage policy supplies the memory:
+//  posix_memalign by default, LAB3 plugs in its huge-page aware
+//  aligned_malloc (aligned.h).
+//
+//  Header-only, C++11; include it as "../common/matrix.h".
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+
+const size_t MATRIX_ALIGN = 64;
+
+/** Default storage: MATRIX_ALIGN-aligned posix_memalign; throws std::bad_alloc. */
+struct MatrixStorage {
+    static void* allocate(size_t bytes)
+    {
+        void* p = nullptr;
+        if (posix_memalign(&p, MATRIX_ALIGN, bytes ? bytes : 1) != 0)
+            throw std::bad_alloc();
+        return p;
+    }
+    static void deallocate(void* p) { std::free(p); }
+};
+
+template <class T>
+class MatrixView {
+public:
+    MatrixView() : p_(nullptr), rows_(0), cols_(0), stride_(0) {}
+    MatrixView(T* data, int rows, int cols, int stride)
+        : p_(data), rows_(rows), cols_(cols), stride_(stride) {}
+
+    // MatrixView<T> → MatrixView<const T>.
+    template <class U>
+    MatrixView(const MatrixView<U>& v,
+               typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = nullptr)
+        : p_(v.data()), rows_(v.rows()), cols_(v.cols()), stride_(v.stride()) {}
+
+    T*  data()   const { return p_; }
+    int rows()   const { return rows_; }
+    int cols()   const { return cols_; }
+    int stride() const { return stride_; }
+
+    T* row(int i) const { return p_ + (size_t)i * stride_; }
+    T& operator()(int i, int j) const { return p_[(size_t)i * stride_ + j]; }
+
+    /** Rows [r0, r0 + nr) × columns [c0, c0 + nc), same stride, no copy. */
+    MatrixView block(int r0, int c0, int nr, int nc) const
+    {
+        return MatrixView(row(r0) + c0, nr, nc, stride_);
+    }
+
+    /** Every element to v; the padding past cols() is not touched. */
+    void fill(const T& v) const
+    {
+        for (int i = 0; i < rows_; ++i)
+            std::fill(row(i), row(i) + cols_, v);
+    }
+
+private:
+    T*  p_;
+    int rows_, cols_, stride_;
+};
+
+template <class T, class Storage = MatrixStorage>
+class Matrix {
+    static_assert(std::is_trivial<T>::value, "Matrix<T> leaves elements uninitialised");
+
+public:
+    /** cols rounded up to a whole MATRIX_ALIGN bytes of T. */
+    static int padded_stride(int cols)
+    {
+        const int per = std::max<int>(1, (int)(MATRIX_ALIGN / sizeof(T)));
+        return (cols + per - 1) / per * per;
+    }
+
+    Matrix() : p_(nullptr), rows_(0), cols_(0), stride_(0), capacity_(0) {}
+    Matrix(int rows, int cols) : Matrix(rows, cols, padded_stride(cols)) {}
+    Matrix(int rows, int cols, int stride) : Matrix() { reshape(rows, cols, stride); }
+
+    Matrix(Matrix&& o) noexcept
+        : p_(o.p_), rows_(o.rows_), cols_(o.cols_), stride_(o.stride_), capacity_(o.capacity_)
+    {
+        o.p_ = nullptr;
+        o.rows_ = o.cols_ = o.stride_ = 0;
+        o.capacity_ = 0;
+    }
+    Matrix& operator=(Matrix&& o) noexcept
+    {
+        if (this != &o) {
+            Storage::deallocate(p_);
+            p_ = o.p_;  rows_ = o.rows_;  cols_ = o.cols_;
+            stride_ = o.stride_;  capacity_ = o.capacity_;
+            o.p_ = nullptr;
+            o.rows_ = o.cols_ = o.stride_ = 0;
+            o.capacity_ = 0;
+        }
+        return *this;
+    }
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+
+    ~Matrix() { Storage::deallocate(p_); }
+
+    /**
+     * New shape, contents unspecified.  Reallocates only when rows × stride
+     * exceeds what is already held, so a buffer reused for panels of
+     * varying height (or for the same shape) stays put.
+     */
+    void reshape(int rows, int cols, int stride)
+    {
+        const size_t need = (size_t)rows * stride;
+        if (need > capacity_) {
+            T* p = static_cast<T*>(Storage::allocate(need * sizeof(T)));
+            Storage::deallocate(p_);
+            p_ = p;
+            capacity_ = need;
+        }
+        rows_ = rows;  cols_ = cols;  stride_ = stride;
+    }
+    void reshape(int rows, int cols) { reshape(rows, cols, padded_stride(cols)); }
+
+    T*       data()         { return p_; }
+    const T* data()   const { return p_; }
+    int      rows()   const { return rows_; }
+    int      cols()   const { return cols_; }
+    int      stride() const { return stride_; }
+
+    T*       row(int i)       { return p_ + (size_t)i * stride_; }
+    const T* row(int i) const { return p_ + (size_t)i * stride_; }
+    T&       operator()(int i, int j)       { return p_[(size_t)i * stride_ + j]; }
+    const T& operator()(int i, int j) const { return p_[(size_t)i * stride_ + j]; }
+
+    MatrixView<T>       view()       { return MatrixView<T>(p_, rows_, cols_, stride_); }
+    MatrixView<const T> view() const { return MatrixView<const T>(p_, rows_, cols_, stride_); }
+    MatrixView<T>       block(int r0, int c0, int nr, int nc)       { return view().block(r0, c0, nr, nc); }
+    MatrixView<const T> block(int r0, int c0, int nr, int nc) const { return view().block(r0, c0, nr, nc); }
+
+    /** Every element to v and the padding after each row to zero. */
+    void fill(const T& v)
+    {
+        for (int i = 0; i < rows_; ++i) {
+            std::fill(row(i), row(i) + cols_, v);
+            std::fill(row(i) + cols_, row(i) + stride_, T());
+        }
+    }
+
+private:
+    T*     p_;
+    int    rows_, cols_, stride_;
+    size_t capacity_;   // elements
+};
+
+#endif // COMMON_MATRIX_H
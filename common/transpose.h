@@ -0,0 +1,49 @@
+#ifndef COMMON_TRANSPOSE_H
+#define COMMON_TRANSPOSE_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  transpose.h  –  cache-oblivious matrix transpose shared by the LAB programs
+//
+//  The naive `BT[j][i] = B[i][j]` reads one array in order and writes the
+//  other a whole row apart per element, so every store lands on a new cache
+//  line (and, past a few thousand rows, a new TLB page).  transpose()
+//  instead halves the larger dimension recursively until a block of both
+//  arrays fits in L1, whatever the cache sizes are, and moves each block as
+//  K × K tiles transposed in SIMD registers (transpose_impl.h: 2 × 2 / 4 × 4
+//  with SSE2, 4 × 4 / 8 × 8 with AVX2, 8 × 8 / 8 × 8 with AVX-512, for
+//  double / float).  A large, line-aligned dst (a Matrix) is written with
+//  non-temporal stores.  Large blocks recurse as OpenMP tasks, so the
+//  out-of-place and in-place variants both run on the current team.
+//
+//  Build: link transpose.cpp and transpose_<isa>.cpp, the latter compiled
+//  with their ISA flags (see LAB1/Makefile or LAB3/Makefile).  The kernel
+//  level comes from cpuid; TRANSPOSE_ISA=sse2|avx2 forces a lower one.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "matrix.h"
+
+/**
+ * dst = srcᵀ: src is rows × cols, row-major with row stride lds; dst is
+ * cols × rows with row stride ldd.  The two must not overlap.
+ */
+void transpose(int rows, int cols, const double* src, int lds, double* dst, int ldd);
+void transpose(int rows, int cols, const float*  src, int lds, float*  dst, int ldd);
+
+/** a = aᵀ for the n × n matrix at a, row stride lda, in place. */
+void transpose_inplace(int n, double* a, int lda);
+void transpose_inplace(int n, float*  a, int lda);
+
+/** ISA level of the tile kernels: "avx512", "avx2" or "sse2". */
+const char* transpose_isa();
+
+// The same on matrix views; dst must be src.cols() × src.rows().
+inline void transpose(MatrixView<const double> src, MatrixView<double> dst)
+{
+    transpose(src.rows(), src.cols(), src.data(), src.stride(), dst.data(), dst.stride());
+}
+inline void transpose(MatrixView<const float> src, MatrixView<float> dst)
+{
+    transpose(src.rows(), src.cols(), src.data(), src.stride(), dst.data(), dst.stride());
+}
+
+#endif // COMMON_TRANSPOSE_H
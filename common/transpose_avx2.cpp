@@ -0,0 +1,8 @@
+// Compiled with $(ISA_AVX2) = -mavx2 -mfma (see LAB1/Makefile, LAB3/Makefile).
+#include "transpose_impl.h"
+
+const TransposeKernels& transpose_kernels_avx2()
+{
+    static const TransposeKernels k = make_table("avx2");
+    return k;
+}
@@ -0,0 +1,294 @@
+// ─────────────────────────────────────────────────────────────────────────────
+//  transpose_impl.h  –  the leaf kernels, included by exactly one
+//  transpose_<isa>.cpp
+//
+//  As in LAB3/kernels_impl.h, everything lives in an anonymous namespace so
+//  that no inline function compiled for AVX-512 can be picked by the linker
+//  for the whole program.
+//
+//  A tile is K rows loaded into K registers, transposed with unpack and
+//  lane shuffles, and stored as K rows of the other matrix: per tile, K
+//  full-width loads and K full-width stores instead of K² scalar moves,
+//  and every store fills whole cache-line segments.
+// ─────────────────────────────────────────────────────────────────────────────
+
+#include "transpose_kernels.h"
+#include <immintrin.h>
+
+#ifndef __SSE2__
+#error "transpose_impl.h needs at least SSE2"
+#endif
+
+namespace {
+
+// ── double ───────────────────────────────────────────────────────────────────
+#if defined(__AVX512F__)
+
+struct D {
+    typedef double  T;
+    typedef __m512d reg;
+    enum { K = 8 };
+    static inline reg  load(const T* p)   { return _mm512_loadu_pd(p); }
+    static inline void store(T* p, reg v)  { _mm512_storeu_pd(p, v); }
+    static inline void stream(T* p, reg v) { _mm512_stream_pd(p, v); }
+    // Three rounds of two-source permutes (vpermt2pd), each pairing
+    // registers i and i + w for w = 1, 2, 4: interleave single elements,
+    // then 128-bit lane pairs, then 256-bit halves.
+    static inline void trans(reg* r)
+    {
+        const __m512i lo1 = _mm512_set_epi64(14, 6, 12, 4, 10, 2, 8, 0);
+        const __m512i hi1 = _mm512_set_epi64(15, 7, 13, 5, 11, 3, 9, 1);
+        const __m512i lo2 = _mm512_set_epi64(13, 12, 5, 4, 9, 8, 1, 0);
+        const __m512i hi2 = _mm512_set_epi64(15, 14, 7, 6, 11, 10, 3, 2);
+        const __m512i lo4 = _mm512_set_epi64(11, 10, 9, 8, 3, 2, 1, 0);
+        const __m512i hi4 = _mm512_set_epi64(15, 14, 13, 12, 7, 6, 5, 4);
+        reg t[8], u[8];
+        for (int i = 0; i < 8; i += 2) {
+            t[i]     = _mm512_permutex2var_pd(r[i], lo1, r[i + 1]);
+            t[i + 1] = _mm512_permutex2var_pd(r[i], hi1, r[i + 1]);
+        }
+        for (int h = 0; h < 8; h += 4)
+            for (int c = 0; c < 2; ++c) {
+                u[h + c]     = _mm512_permutex2var_pd(t[h + c], lo2, t[h + 2 + c]);
+                u[h + 2 + c] = _mm512_permutex2var_pd(t[h + c], hi2, t[h + 2 + c]);
+            }
+        for (int c = 0; c < 4; ++c) {
+            r[c]     = _mm512_permutex2var_pd(u[c], lo4, u[c + 4]);
+            r[c + 4] = _mm512_permutex2var_pd(u[c], hi4, u[c + 4]);
+        }
+    }
+};
+
+#elif defined(__AVX__)
+
+struct D {
+    typedef double  T;
+    typedef __m256d reg;
+    enum { K = 4 };
+    static inline reg  load(const T* p)   { return _mm256_loadu_pd(p); }
+    static inline void store(T* p, reg v)  { _mm256_storeu_pd(p, v); }
+    static inline void stream(T* p, reg v) { _mm256_stream_pd(p, v); }
+    static inline void trans(reg* r)
+    {
+        const reg t0 = _mm256_unpacklo_pd(r[0], r[1]), t1 = _mm256_unpackhi_pd(r[0], r[1]);
+        const reg t2 = _mm256_unpacklo_pd(r[2], r[3]), t3 = _mm256_unpackhi_pd(r[2], r[3]);
+        r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+        r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+        r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+        r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+};
+
+#else
+
+struct D {
+    typedef double  T;
+    typedef __m128d reg;
+    enum { K = 2 };
+    static inline reg  load(const T* p)   { return _mm_loadu_pd(p); }
+    static inline void store(T* p, reg v)  { _mm_storeu_pd(p, v); }
+    static inline void stream(T* p, reg v) { _mm_stream_pd(p, v); }
+    static inline void trans(reg* r)
+    {
+        const reg t = _mm_unpacklo_pd(r[0], r[1]);
+        r[1] = _mm_unpackhi_pd(r[0], r[1]);
+        r[0] = t;
+    }
+};
+
+#endif
+
+// ── float ────────────────────────────────────────────────────────────────────
+#if defined(__AVX__)
+
+// 8 × 8 on ymm at the AVX-512 level too: 16 × 16 on zmm needs 32 registers
+// for the swap kernel alone and gains nothing once the stores are whole
+// 32-byte rows.
+struct F {
+    typedef float  T;
+    typedef __m256 reg;
+    enum { K = 8 };
+    static inline reg  load(const T* p)   { return _mm256_loadu_ps(p); }
+    static inline void store(T* p, reg v)  { _mm256_storeu_ps(p, v); }
+    static inline void stream(T* p, reg v) { _mm256_stream_ps(p, v); }
+    static inline void trans(reg* r)
+    {
+        reg t[8], s[8];
+        for (int i = 0; i < 8; i += 2) {
+            t[i]     = _mm256_unpacklo_ps(r[i], r[i + 1]);
+            t[i + 1] = _mm256_unpackhi_ps(r[i], r[i + 1]);
+        }
+        for (int h = 0; h < 8; h += 4) {
+            s[h]     = _mm256_shuffle_ps(t[h],     t[h + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            s[h + 1] = _mm256_shuffle_ps(t[h],     t[h + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            s[h + 2] = _mm256_shuffle_ps(t[h + 1], t[h + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            s[h + 3] = _mm256_shuffle_ps(t[h + 1], t[h + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+        for (int c = 0; c < 4; ++c) {
+            r[c]     = _mm256_permute2f128_ps(s[c], s[c + 4], 0x20);
+            r[c + 4] = _mm256_permute2f128_ps(s[c], s[c + 4], 0x31);
+        }
+    }
+};
+
+#else
+
+struct F {
+    typedef float  T;
+    typedef __m128 reg;
+    enum { K = 4 };
+    static inline reg  load(const T* p)   { return _mm_loadu_ps(p); }
+    static inline void store(T* p, reg v)  { _mm_storeu_ps(p, v); }
+    static inline void stream(T* p, reg v) { _mm_stream_ps(p, v); }
+    static inline void trans(reg* r)      { _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]); }
+};
+
+#endif
+
+// ── Leaves ───────────────────────────────────────────────────────────────────
+
+template <class V>
+inline void load_tile(const typename V::T* p, long ld, typename V::reg* r)
+{
+    for (int k = 0; k < V::K; ++k)
+        r[k] = V::load(p + k * ld);
+}
+
+template <class V>
+inline void store_tile(typename V::T* p, long ld, const typename V::reg* r)
+{
+    for (int k = 0; k < V::K; ++k)
+        V::store(p + k * ld, r[k]);
+}
+
+template <class V>
+void block(int rows, int cols, const typename V::T* s, long lds, typename V::T* d, long ldd)
+{
+    const int K = V::K;
+    typename V::reg r[K];
+    int i = 0;
+    for (; i + K <= rows; i += K) {
+        int j = 0;
+        for (; j + K <= cols; j += K) {
+            load_tile<V>(s + i * lds + j, lds, r);
+            V::trans(r);
+            store_tile<V>(d + j * ldd + i, ldd, r);
+        }
+        for (; j < cols; ++j)
+            for (int k = i; k < i + K; ++k)
+                d[j * ldd + k] = s[k * lds + j];
+    }
+    for (; i < rows; ++i)
+        for (int j = 0; j < cols; ++j)
+            d[j * ldd + i] = s[i * lds + j];
+}
+
+// block() for a destination that will not be read again soon: G row tiles
+// (G·K elements = one 64-byte line) are transposed together and every line
+// of d is written whole by non-temporal stores, which skips the read for
+// ownership a normal store pays for each line it misses.  Needs d and ldd
+// line-aligned, else it is block().
+template <class V>
+void stream(int rows, int cols, const typename V::T* s, long lds, typename V::T* d, long ldd)
+{
+    typedef typename V::T T;
+    const int K = V::K, G = 64 / (K * (int)sizeof(T)), L = G * K;
+    if (((size_t)d & 63) || (ldd * sizeof(T)) & 63) {
+        block<V>(rows, cols, s, lds, d, ldd);
+        return;
+    }
+    typename V::reg r[G][K];
+    int i = 0;
+    for (; i + L <= rows; i += L) {
+        int j = 0;
+        for (; j + K <= cols; j += K) {
+            for (int g = 0; g < G; ++g) {
+                load_tile<V>(s + (i + g * K) * lds + j, lds, r[g]);
+                V::trans(r[g]);
+            }
+            for (int k = 0; k < K; ++k)
+                for (int g = 0; g < G; ++g)
+                    V::stream(d + (j + k) * ldd + i + g * K, r[g][k]);
+        }
+        for (; j < cols; ++j)
+            for (int k = i; k < i + L; ++k)
+                d[j * ldd + k] = s[k * lds + j];
+    }
+    if (i < rows)
+        block<V>(rows - i, cols, s + i * lds, lds, d + i, ldd);
+    _mm_sfence();   // order the streamed lines before anything after the leaf
+}
+
+// One K × K tile pair: a ← bᵀ, b ← aᵀ (a == b transposes a diagonal tile).
+template <class V>
+inline void swap_tile(typename V::T* a, long lda, typename V::T* b, long ldb)
+{
+    typename V::reg x[V::K], y[V::K];
+    load_tile<V>(a, lda, x);
+    load_tile<V>(b, ldb, y);
+    V::trans(x);
+    V::trans(y);
+    store_tile<V>(b, ldb, x);
+    store_tile<V>(a, lda, y);
+}
+
+template <class V>
+void swap(int rows, int cols, typename V::T* a, long lda, typename V::T* b, long ldb)
+{
+    typedef typename V::T T;
+    const int K = V::K;
+    int i = 0;
+    for (; i + K <= rows; i += K) {
+        int j = 0;
+        for (; j + K <= cols; j += K)
+            swap_tile<V>(a + i * lda + j, lda, b + j * ldb + i, ldb);
+        for (; j < cols; ++j)
+            for (int k = i; k < i + K; ++k) {
+                const T t = a[k * lda + j];
+                a[k * lda + j] = b[j * ldb + k];
+                b[j * ldb + k] = t;
+            }
+    }
+    for (; i < rows; ++i)
+        for (int j = 0; j < cols; ++j) {
+            const T t = a[i * lda + j];
+            a[i * lda + j] = b[j * ldb + i];
+            b[j * ldb + i] = t;
+        }
+}
+
+template <class V>
+void diag(int n, typename V::T* a, long lda)
+{
+    typedef typename V::T T;
+    const int K = V::K, full = n / K * K;
+    for (int i = 0; i < full; i += K) {
+        swap_tile<V>(a + i * lda + i, lda, a + i * lda + i, lda);
+        for (int j = i + K; j < full; j += K)
+            swap_tile<V>(a + i * lda + j, lda, a + j * lda + i, lda);
+    }
+    // The ragged last rows against everything before them, then the corner.
+    for (int i = full; i < n; ++i)
+        for (int j = 0; j < i; ++j) {
+            const T t = a[i * lda + j];
+            a[i * lda + j] = a[j * lda + i];
+            a[j * lda + i] = t;
+        }
+}
+
+TransposeKernels make_table(const char* isa)
+{
+    TransposeKernels k;
+    k.isa = isa;
+    k.f64.block  = block<D>;
+    k.f64.stream = stream<D>;
+    k.f64.swap   = swap<D>;
+    k.f64.diag   = diag<D>;
+    k.f32.block  = block<F>;
+    k.f32.stream = stream<F>;
+    k.f32.swap   = swap<F>;
+    k.f32.diag   = diag<F>;
+    return k;
+}
+
+} // namespace
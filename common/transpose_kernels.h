@@ -0,0 +1,37 @@
+#ifndef COMMON_TRANSPOSE_KERNELS_H
+#define COMMON_TRANSPOSE_KERNELS_H
+
+// ─────────────────────────────────────────────────────────────────────────────
+//  Leaf kernels of transpose(), one table per ISA level
+//  (transpose_<isa>.cpp, each compiled with that level's -m flags).
+//
+//  Every kernel walks its block as K × K register tiles and finishes the
+//  ragged edges element by element; the recursion in transpose.cpp only
+//  hands them blocks small enough for L1.
+// ─────────────────────────────────────────────────────────────────────────────
+
+template <class T>
+struct TransposeLeaves {
+    // d = sᵀ: s is rows × cols (stride lds), d cols × rows (stride ldd).
+    void (*block)(int rows, int cols, const T* s, long lds, T* d, long ldd);
+    // The same with d written by whole-line non-temporal stores (when d
+    // and ldd are 64-byte aligned), for destinations larger than the cache.
+    void (*stream)(int rows, int cols, const T* s, long lds, T* d, long ldd);
+    // a (rows × cols) and b (cols × rows) swapped and transposed:
+    // a ← bᵀ, b ← aᵀ.  The two blocks must not overlap.
+    void (*swap)(int rows, int cols, T* a, long lda, T* b, long ldb);
+    // a = aᵀ for an n × n diagonal block.
+    void (*diag)(int n, T* a, long lda);
+};
+
+struct TransposeKernels {
+    const char*             isa;
+    TransposeLeaves<double> f64;
+    TransposeLeaves<float>  f32;
+};
+
+const TransposeKernels& transpose_kernels_sse2();
+const TransposeKernels& transpose_kernels_avx2();
+const TransposeKernels& transpose_kernels_avx512();
+
+#endif // COMMON_TRANSPOSE_KERNELS_H
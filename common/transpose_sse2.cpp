@@ -0,0 +1,8 @@
+// Compiled with $(ISA_SSE2) = -msse2 (see LAB1/Makefile, LAB3/Makefile).
+#include "transpose_impl.h"
+
+const TransposeKernels& transpose_kernels_sse2()
+{
+    static const TransposeKernels k = make_table("sse2");
+    return k;
+}